@@ -0,0 +1,53 @@
+﻿#pragma once
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "TextArena.h"
+#include "types.h"
+namespace rwin
+{
+    // Growable ring buffer of pending events, the capacity is always a power of two
+    struct EventQueue {
+        explicit EventQueue(std::size_t capacity = 256);
+        // When coalescing is enabled a CursorMove is merged into a CursorMove for the same window at the back of the queue
+        void Push(const WindowEvent& event);
+        void SetMotionCoalescing(const MotionCoalescing& coalescing);
+        WindowEvent& Back();
+        // Contiguous events starting at the front, shorter than Size() when the buffer wraps around
+        std::span<const WindowEvent> Peek() const;
+        void Consume(std::size_t count);
+        std::uint64_t Pop(const std::span<WindowEvent>& events);
+        [[nodiscard]] std::size_t Size() const;
+        [[nodiscard]] bool Empty() const;
+        void Clear();
+        // Samples merged into event, empty while coalescing is off or once the event's samples were released
+        std::span<const MotionSample> GetMotionHistory(const CursorMoveEvent& event) const;
+        // Drops the samples of events no longer queued, events popped since the last call keep theirs until now
+        void ReleaseHistory();
+        // Copies the text of a Text or Composition event for this queue, it stays put until ReleaseText frees it
+        std::string_view StoreText(const std::string_view& text);
+        // Frees the stored text once every event was taken, events popped since the last call keep theirs until now
+        void ReleaseText();
+        [[nodiscard]] std::size_t TextSize() const;
+    private:
+        void Grow();
+        bool TryCoalesce(const WindowEvent& event);
+        MotionCoalescing _coalescing = MotionCoalescing::None;
+        // Only recorded while coalescing, every other CursorMove is a sample of its own
+        std::vector<MotionSample> _motionHistory{};
+        // Index of the first sample in the history, indices only grow so an offset is never reused for newer samples
+        std::uint32_t _historyBase = 0;
+        // Per queue so a window that is never read only keeps its own text alive
+        TextArena _text{};
+        std::vector<WindowEvent> _events{};
+        std::size_t _mask = 0;
+        std::size_t _head = 0;
+        std::size_t _size = 0;
+    };
+
+    // Finds the queue holding the oldest event, count is how many of its contiguous front events come before the front of every other queue
+    EventQueue* FindOldestRun(const std::span<EventQueue* const>& queues, std::size_t& count);
+    // Pops from several queues in sequence order
+    std::uint64_t PopOrdered(const std::span<EventQueue* const>& queues, const std::span<WindowEvent>& events);
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <chrono>
 #include <cstdint>
 #include <span>
 #include <vulkan/vulkan.hpp>
@@ -66,23 +67,71 @@ namespace rwin {
         virtual ~IWindowManager() = default;
         virtual vk::SurfaceKHR CreateSurface(const std::uint64_t& id,const vk::Instance& instance) = 0;
         virtual std::uint64_t GetEvents(const std::span<WindowEvent>& events) = 0;
+        // Pending events stored contiguously from the front of the queue, valid until the next call that modifies the queue
+        virtual std::span<const WindowEvent> PeekEvents() = 0;
+        virtual void ConsumeEvents(const std::uint64_t& count) = 0;
+        // Each window has its own queue, these only touch the queue of the given window
+        virtual std::uint64_t GetEvents(const std::uint64_t& id, const std::span<WindowEvent>& events) = 0;
+        virtual std::span<const WindowEvent> PeekEvents(const std::uint64_t& id) = 0;
+        virtual void ConsumeEvents(const std::uint64_t& id, const std::uint64_t& count) = 0;
+        // 0 when the platform could not create the window, no other call resolves that handle
         virtual std::uint64_t Create(const std::string_view& title,const Extent2D& size,const Flags<WindowFlags>& flags) = 0;
         virtual void Destroy(const std::uint64_t& id) = 0;
         virtual Extent2D GetClientSize(const std::uint64_t& id) = 0;
         virtual Point2D GetClientPosition(const std::uint64_t& id) = 0;
         virtual Vector2 GetCursorPosition(const std::uint64_t& id) = 0;
         virtual void Show(const std::uint64_t& id) = 0;
+        // On Wayland the surface is unmapped, nothing may be presented to it until VisibilityChanged reports it visible
+        // again after Show
         virtual void Hide(const std::uint64_t& id) = 0;
         virtual void Minimize(const std::uint64_t& id) = 0;
         virtual void Maximize(const std::uint64_t& id) = 0;
         virtual float GetDpi(const std::uint64_t& id) = 0;
         virtual float GetDefaultDpi() = 0;
         virtual void PumpEvents() = 0;
+        // Sleeps until the platform has events for us or the timeout expires then dispatches them, std::chrono::nanoseconds::max() waits forever
+        virtual void WaitEvents(const std::chrono::nanoseconds& timeout) = 0;
+        // Blocks until the platform has processed every request made so far and dispatches the events they produced
+        virtual void Sync() = 0;
+        // Descriptor that becomes readable when the platform has events for us, -1 when the platform does not have one
+        virtual int GetEventFd() = 0;
+        // Call before waiting on GetEventFd and follow with Dispatch, returns false when events were queued since the last Dispatch and the caller should not block
+        virtual bool PrepareRead() = 0;
+        // Reads the platform events if the descriptor became readable and dispatches them
+        virtual void Dispatch(const bool& readable) = 0;
+        // Reads and translates input on a dedicated thread, GetEvents then only drains what that thread produced
+        virtual void StartInputThread() = 0;
+        virtual void StopInputThread() = 0;
+        virtual void SetMotionCoalescing(const MotionCoalescing& coalescing) = 0;
         virtual void GetRequiredExtensions(std::vector<const char*>& extensions) = 0;
         virtual void SetHitTestCallback(const std::uint64_t& id, const std::function<HitTestResult(const Vector2&)>& callback) = 0;
         virtual void ClearHitTestCallback(const std::uint64_t& id) = 0;
         virtual void SetDropCallbacks(const std::uint64_t& id, const DropCallbacks& callbacks) = 0;
         virtual void ClearDropCallbacks(const std::uint64_t& id) = 0;
+        // Event types not in the mask are dropped by the backend before they are built or queued, windows start with
+        // DEFAULT_EVENT_MASK and RawMotion is only produced while some window's mask takes it
+        virtual void SetEventMask(const std::uint64_t& id, const Flags<WindowEventType>& mask) = 0;
+        virtual std::uint64_t GetSuppressedEventCount(const std::uint64_t& id) = 0;
+        // Held keys and buttons, cursor position, modifiers and the scroll the last pump delivered, kept current by the backend
+        virtual InputSnapshot GetInputSnapshot(const std::uint64_t& id) = 0;
+        // Pointer owned by the application, lets it keep per window state without its own map keyed by id
+        virtual void SetUserData(const std::uint64_t& id, void* data) = 0;
+        virtual void* GetUserData(const std::uint64_t& id) = 0;
+        // Holds the cursor where it is while the window has pointer focus, RawMotion keeps reporting movement
+        virtual void LockPointer(const std::uint64_t& id) = 0;
+        // Keeps the cursor inside region, given in client coordinates, while the window has pointer focus
+        virtual void ConfinePointer(const std::uint64_t& id, const WindowRect& region) = 0;
+        // Undoes LockPointer and ConfinePointer
+        virtual void ReleasePointer(const std::uint64_t& id) = 0;
+        // Every position merged into a CursorMove event with its own timestamp, valid until the first pump after the
+        // event left its queue. Only recorded while motion coalescing is on, empty otherwise
+        virtual std::span<const MotionSample> GetMotionHistory(const CursorMoveEvent& event) = 0;
+        // Asks for a FrameReady event once drawing again is worthwhile, call it before presenting so the present carries
+        // the request. Hidden windows may not get one until they are shown. While the window's mask takes Presented the
+        // present also reports back with a Presented event
+        virtual void RequestFrame(const std::uint64_t& id) = 0;
+        // The last state the platform reported, changes arrive as StateChanged events
+        virtual WindowState GetState(const std::uint64_t& id) = 0;
         static IWindowManager* Get();
     };
 }
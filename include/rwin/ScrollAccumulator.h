@@ -0,0 +1,22 @@
+#pragma once
+#include <utility>
+#include "rwin/types.h"
+namespace rwin
+{
+    // Scroll gathered by the input handlers between pumps, the pump that delivers it hands the sum to the snapshot
+    struct ScrollAccumulator {
+        void Add(const Vector2& delta)
+        {
+            _pending.x += delta.x;
+            _pending.y += delta.y;
+        }
+
+        // Called once per pump after its input was handled, a pump without scroll leaves the snapshot at zero
+        void Publish(InputSnapshot& input)
+        {
+            input.scrollDelta = std::exchange(_pending, Vector2{});
+        }
+    private:
+        Vector2 _pending{};
+    };
+}
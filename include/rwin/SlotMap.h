@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <utility>
+#include <vector>
+namespace rwin
+{
+    // Pooled storage addressed by handles packing a generation in the high 32 bits and a slot index in the low 32 bits.
+    // Erasing bumps the slot's generation so old handles stop resolving, values never move while alive.
+    // Erased slots are reused so memory follows the peak number of live values, not how many were ever created
+    template <typename T>
+    struct SlotMap {
+        template <typename... Args>
+        std::uint64_t Emplace(Args&&... args)
+        {
+            std::uint32_t index;
+            if (_freeSlots.empty())
+            {
+                index = static_cast<std::uint32_t>(_slots.size());
+                _slots.emplace_back();
+            }
+            else
+            {
+                index = _freeSlots.back();
+                _freeSlots.pop_back();
+            }
+
+            auto& slot = _slots[index];
+            slot.value.emplace(std::forward<Args>(args)...);
+            _size++;
+            return static_cast<std::uint64_t>(slot.generation) << 32 | index;
+        }
+
+        // nullptr when the handle was erased or never existed
+        T* Get(const std::uint64_t& handle)
+        {
+            const auto index = static_cast<std::uint32_t>(handle);
+            if (index >= _slots.size())
+            {
+                return nullptr;
+            }
+
+            auto& slot = _slots[index];
+            if (slot.generation != static_cast<std::uint32_t>(handle >> 32) || !slot.value.has_value())
+            {
+                return nullptr;
+            }
+            return &*slot.value;
+        }
+
+        bool Erase(const std::uint64_t& handle)
+        {
+            if (Get(handle) == nullptr)
+            {
+                return false;
+            }
+
+            const auto index = static_cast<std::uint32_t>(handle);
+            auto& slot = _slots[index];
+            slot.value.reset();
+            // A slot whose generation would wrap is retired instead of reused so an old handle can never match it again
+            if (++slot.generation != 0)
+            {
+                _freeSlots.push_back(index);
+            }
+            _size--;
+            return true;
+        }
+
+        // Visits every live value, erased slots are skipped
+        template <typename Fn>
+        void ForEach(Fn&& fn)
+        {
+            for (auto& slot : _slots)
+            {
+                if (slot.value.has_value())
+                {
+                    fn(*slot.value);
+                }
+            }
+        }
+
+        [[nodiscard]] std::size_t Size() const
+        {
+            return _size;
+        }
+
+        // Slots allocated so far, live or free, memory follows this rather than the number of values ever created
+        [[nodiscard]] std::size_t Capacity() const
+        {
+            return _slots.size();
+        }
+
+    private:
+        struct Slot {
+            std::optional<T> value{};
+            std::uint32_t generation = 1;
+        };
+
+        // deque keeps values in place when it grows
+        std::deque<Slot> _slots{};
+        std::vector<std::uint32_t> _freeSlots{};
+        std::size_t _size = 0;
+    };
+}
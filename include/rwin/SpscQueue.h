@@ -0,0 +1,60 @@
+﻿#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <vector>
+namespace rwin
+{
+    // Bounded lock free queue for exactly one producer thread and one consumer thread
+    template <typename T>
+    struct SpscQueue {
+        explicit SpscQueue(const std::size_t capacity = 4096) : _items(std::bit_ceil(capacity)), _mask(_items.size() - 1)
+        {
+        }
+
+        // Producer only, returns false when the queue is full
+        bool TryPush(const T& item)
+        {
+            const auto tail = _tail.load(std::memory_order_relaxed);
+            if (tail - _cachedHead == _items.size())
+            {
+                _cachedHead = _head.load(std::memory_order_acquire);
+                if (tail - _cachedHead == _items.size())
+                {
+                    return false;
+                }
+            }
+
+            _items[tail & _mask] = item;
+            _tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only, returns false when the queue is empty
+        bool TryPop(T& item)
+        {
+            const auto head = _head.load(std::memory_order_relaxed);
+            if (head == _cachedTail)
+            {
+                _cachedTail = _tail.load(std::memory_order_acquire);
+                if (head == _cachedTail)
+                {
+                    return false;
+                }
+            }
+
+            item = _items[head & _mask];
+            _head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        std::vector<T> _items;
+        std::size_t _mask;
+        // Each side keeps its own cache line and a cached copy of the other side's index
+        alignas(64) std::atomic<std::size_t> _head{0};
+        std::size_t _cachedTail{0};
+        alignas(64) std::atomic<std::size_t> _tail{0};
+        std::size_t _cachedHead{0};
+    };
+}
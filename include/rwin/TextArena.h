@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+namespace rwin
+{
+    // Chunked storage for the text of events, stored strings never move so events can point into it until Clear
+    struct TextArena {
+        explicit TextArena(std::size_t chunkSize = 4096);
+        std::string_view Store(const std::string_view& text);
+        // Keeps the regular chunks for reuse and frees the ones made for oversized strings
+        void Clear();
+        [[nodiscard]] std::size_t Size() const;
+    private:
+        struct Chunk {
+            std::unique_ptr<char[]> data;
+            std::size_t capacity;
+        };
+
+        std::size_t _chunkSize;
+        std::vector<Chunk> _chunks{};
+        std::size_t _current = 0;
+        std::size_t _used = 0;
+        std::size_t _size = 0;
+    };
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <span>
+#include <type_traits>
+#include "types.h"
+namespace rwin
+{
+    // Merges lambdas into one overload set, overloaded{[](const KeyEvent&){}, [](const ResizeEvent&){}}
+    template <typename... Handlers>
+    struct overloaded : Handlers...
+    {
+        using Handlers::operator()...;
+    };
+
+    template <typename... Handlers>
+    overloaded(Handlers...) -> overloaded<Handlers...>;
+
+    // Calls the overload of handler that takes the event's struct, event types without one are skipped at compile time
+    template <typename Handler>
+    void dispatch(const WindowEvent& event, Handler&& handler)
+    {
+        const auto call = [&handler]<typename T>(const T& typed)
+        {
+            if constexpr (std::is_invocable_v<Handler&, const T&>)
+            {
+                handler(typed);
+            }
+        };
+
+        switch (event.info.type)
+        {
+        case WindowEventType::Key:
+            call(event.key);
+            break;
+        case WindowEventType::Resize:
+            call(event.resize);
+            break;
+        case WindowEventType::Minimize:
+            call(event.minimize);
+            break;
+        case WindowEventType::Maximize:
+            call(event.maximize);
+            break;
+        case WindowEventType::Scroll:
+            call(event.scroll);
+            break;
+        case WindowEventType::CursorMove:
+            call(event.cursorMove);
+            break;
+        case WindowEventType::CursorButton:
+            call(event.cursorButton);
+            break;
+        case WindowEventType::Close:
+            call(event.close);
+            break;
+        case WindowEventType::Text:
+            call(event.text);
+            break;
+        case WindowEventType::Composition:
+            call(event.composition);
+            break;
+        case WindowEventType::RawMotion:
+            call(event.rawMotion);
+            break;
+        case WindowEventType::FrameReady:
+            call(event.frameReady);
+            break;
+        case WindowEventType::Presented:
+            call(event.presented);
+            break;
+        case WindowEventType::ScaleChanged:
+            call(event.scaleChanged);
+            break;
+        case WindowEventType::StateChanged:
+            call(event.stateChanged);
+            break;
+        case WindowEventType::VisibilityChanged:
+            call(event.visibilityChanged);
+            break;
+        // Both focus kinds share FocusEvent, check type to tell them apart
+        case WindowEventType::CursorFocus:
+            call(event.cursorFocus);
+            break;
+        case WindowEventType::KeyboardFocus:
+            call(event.keyboardFocus);
+            break;
+        default:
+            break;
+        }
+    }
+
+    template <typename Handler>
+    void dispatch(const std::span<const WindowEvent>& events, Handler&& handler)
+    {
+        for (const auto& event : events)
+        {
+            dispatch(event, handler);
+        }
+    }
+}
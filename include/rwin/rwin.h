@@ -1,4 +1,5 @@
 ﻿#pragma once
+#include <chrono>
 #include <functional>
 #include <vulkan/vulkan.hpp>
 #include "flags.h"
@@ -9,6 +10,11 @@ namespace rwin
     struct DropCallbacks;
     RWIN_API vk::SurfaceKHR createSurface(const std::uint64_t& id,const vk::Instance& instance);
     RWIN_API std::uint64_t getEvents(const std::span<WindowEvent>& events);
+    RWIN_API std::span<const WindowEvent> peekEvents();
+    RWIN_API void consumeEvents(const std::uint64_t& count);
+    RWIN_API std::uint64_t getWindowEvents(const std::uint64_t& id, const std::span<WindowEvent>& events);
+    RWIN_API std::span<const WindowEvent> peekWindowEvents(const std::uint64_t& id);
+    RWIN_API void consumeWindowEvents(const std::uint64_t& id, const std::uint64_t& count);
     RWIN_API std::uint64_t createWindow(const std::string_view& title,const Extent2D& size,const Flags<WindowFlags>& flags);
     RWIN_API void destroyWindow(const std::uint64_t& id);
     RWIN_API Extent2D getWindowClientSize(const std::uint64_t& id);
@@ -21,9 +27,28 @@ namespace rwin
     RWIN_API float getWindowDpi(const std::uint64_t& id);
     RWIN_API float getDefaultDpi();
     RWIN_API void pumpEvents();
+    RWIN_API void syncEvents();
+    RWIN_API int getEventFd();
+    RWIN_API bool prepareRead();
+    RWIN_API void dispatchEvents(const bool& readable);
+    RWIN_API void startInputThread();
+    RWIN_API void stopInputThread();
+    RWIN_API void waitEvents(const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max());
+    RWIN_API void setMotionCoalescing(const MotionCoalescing& coalescing);
     RWIN_API void getRequiredExtensions(std::vector<const char*>& extensions);
     RWIN_API void setWindowHitTestCallback(const std::uint64_t& id, const std::function<HitTestResult(const Vector2&)>& callback);
     RWIN_API void clearWindowHitTestCallback(const std::uint64_t& id);
     RWIN_API void setWindowDropCallbacks(const std::uint64_t& id, const DropCallbacks& callbacks);
     RWIN_API void clearWindowDropCallbacks(const std::uint64_t& id);
+    RWIN_API void setWindowEventMask(const std::uint64_t& id, const Flags<WindowEventType>& mask);
+    RWIN_API std::uint64_t getWindowSuppressedEventCount(const std::uint64_t& id);
+    RWIN_API InputSnapshot getInputSnapshot(const std::uint64_t& id);
+    RWIN_API void setWindowUserData(const std::uint64_t& id, void* data);
+    RWIN_API void* getWindowUserData(const std::uint64_t& id);
+    RWIN_API void lockWindowPointer(const std::uint64_t& id);
+    RWIN_API void confineWindowPointer(const std::uint64_t& id, const WindowRect& region);
+    RWIN_API void releaseWindowPointer(const std::uint64_t& id);
+    RWIN_API std::span<const MotionSample> getMotionHistory(const CursorMoveEvent& event);
+    RWIN_API void requestWindowFrame(const std::uint64_t& id);
+    RWIN_API WindowState getWindowState(const std::uint64_t& id);
 }
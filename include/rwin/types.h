@@ -1,5 +1,7 @@
 #pragma once
+#include <bitset>
 #include <cstdint>
+#include <string_view>
 namespace rwin
 {
     enum class Platform
@@ -82,22 +84,42 @@ namespace rwin
         Text,
     };
 
+    // Bit values so a set of types can be held in Flags<WindowEventType>
     enum class WindowEventType : uint32_t
     {
-        Key,
-        Resize,
-        Minimize,
-        Maximize,
-        Scroll,
-        CursorMove,
-        CursorButton,
-        Close,
-        Text,
-        CursorFocus,
-        KeyboardFocus,
-        DndEnter,
-        DndDrop,
-        DndLeave
+        Key = 1 << 0,
+        Resize = 1 << 1,
+        Minimize = 1 << 2,
+        Maximize = 1 << 3,
+        Scroll = 1 << 4,
+        CursorMove = 1 << 5,
+        CursorButton = 1 << 6,
+        Close = 1 << 7,
+        Text = 1 << 8,
+        CursorFocus = 1 << 9,
+        KeyboardFocus = 1 << 10,
+        DndEnter = 1 << 11,
+        DndDrop = 1 << 12,
+        DndLeave = 1 << 13,
+        Composition = 1 << 14,
+        RawMotion = 1 << 15,
+        FrameReady = 1 << 16,
+        Presented = 1 << 17,
+        ScaleChanged = 1 << 18,
+        StateChanged = 1 << 19,
+        VisibilityChanged = 1 << 20
+    };
+
+    // Mask new windows start with, RawMotion is left out since enabling it switches on raw device input
+    constexpr std::uint32_t DEFAULT_EVENT_MASK = ~static_cast<std::uint32_t>(WindowEventType::RawMotion);
+
+    enum class MotionCoalescing : uint32_t
+    {
+        None,
+        // Keep only the most recent CursorMove of a run
+        Latest,
+        // Keep the most recent CursorMove and sum the deltas of the run into it
+        LatestWithDelta
     };
 
     enum class InputState : uint32_t
@@ -107,6 +129,55 @@ namespace rwin
         Repeat
     };
 
+    enum class ScrollSource : uint32_t
+    {
+        Unknown,
+        // Discrete steps of a mouse wheel
+        Wheel,
+        // Touchpad or touchscreen, ends with a stop when the fingers lift
+        Finger,
+        // Trackpoint or button scrolling, ends with a stop
+        Continuous,
+        // Sideways tilt of a wheel
+        WheelTilt
+    };
+
+    enum class ScrollAxis : uint32_t
+    {
+        Horizontal = 0x0001,
+        Vertical = 0x0002
+    };
+
+    // The first four match wp_presentation_feedback's kind bits
+    enum class PresentFlags : uint32_t
+    {
+        // Presentation was synchronized to the vertical blank
+        Vsync = 0x0001,
+        // The timestamp comes from the display hardware rather than a software clock
+        HwClock = 0x0002,
+        // The hardware signalled that the frame finished scanning out
+        HwCompletion = 0x0004,
+        // The buffer was scanned out directly without a composition copy
+        ZeroCopy = 0x0008,
+        // The frame was never shown, a later one replaced it
+        Discarded = 0x0100
+    };
+
+    enum class WindowState : uint32_t
+    {
+        None = 0,
+        // Has keyboard focus and is drawn as the active window
+        Active = 0x0001,
+        Maximized = 0x0002,
+        Fullscreen = 0x0004,
+        // Snapped against an edge of the screen or another window
+        Tiled = 0x0008,
+        // Minimized, on another workspace or fully covered, nothing drawn will be seen
+        Suspended = 0x0010,
+        // Only reported where the platform knows it, Wayland compositors report Suspended instead
+        Minimized = 0x0020
+    };
+
     enum class InputModifier : uint32_t
     {
         Shift = 0x0001,
@@ -250,12 +321,18 @@ namespace rwin
     {
         WindowEventType type;
         std::uint64_t windowId;
+        // Nanoseconds on the std::chrono::steady_clock timeline (CLOCK_MONOTONIC on linux), steady_clock::time_point{nanoseconds{timestamp}}
+        std::uint64_t timestamp;
+        // Increases with every queued event across all windows, orders events taken from different window queues
+        std::uint64_t sequence;
     };
 
     struct KeyEvent
     {
         WindowEventType type;
         std::uint64_t windowId;
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
         InputKey key;
         InputState state;
         InputModifier modifier;
@@ -265,6 +342,8 @@ namespace rwin
     {
         WindowEventType type;
         std::uint64_t windowId;
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
         Extent2D size;
     };
 
@@ -272,35 +351,82 @@ namespace rwin
     {
         WindowEventType type;
         std::uint64_t windowId;
-
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
     };
 
     struct MaximizeEvent
     {
         WindowEventType type;
         std::uint64_t windowId;
-
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
     };
 
     struct ScrollEvent
     {
         WindowEventType type;
         std::uint64_t windowId;
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
+        // Pointer frame the event was reported in, events of one hardware report share it and arrive together
+        std::uint64_t frame;
         Vector2 position;
+        // Scroll distance in logical pixels, positive is down and right
         Vector2 delta;
+        // Wheel steps including the fractions high resolution wheels report, zero for sources without steps
+        Vector2 detents;
+        ScrollSource source;
+        // Axes whose scrolling ended with this event, kinetic scrolling starts from here
+        ScrollAxis stopped;
     };
 
     struct CursorMoveEvent
     {
         WindowEventType type;
         std::uint64_t windowId;
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
+        // Pointer frame the event was reported in, events of one hardware report share it and arrive together
+        std::uint64_t frame;
+        Vector2 position;
+        Vector2 delta;
+        // Number of motion samples merged into this event
+        std::uint32_t samples;
+        // Where the merged samples start in the window's motion history, read them with GetMotionHistory
+        std::uint32_t historyOffset;
+    };
+
+    // One cursor position as the platform reported it
+    struct MotionSample
+    {
         Vector2 position;
+        std::uint64_t timestamp;
+    };
+
+    // Pointer movement as the device reported it, unclipped by the window and still sent while the pointer is locked
+    struct RawMotionEvent
+    {
+        WindowEventType type;
+        std::uint64_t windowId;
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
+        // Pointer frame the event was reported in, events of one hardware report share it and arrive together
+        std::uint64_t frame;
+        // With the pointer acceleration the cursor would move by, on Windows raw input comes before acceleration so
+        // this is the unaccelerated delta as well
+        Vector2 delta;
+        Vector2 unaccelerated;
     };
 
     struct CursorButtonEvent
     {
         WindowEventType type;
         std::uint64_t windowId;
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
+        // Pointer frame the event was reported in, events of one hardware report share it and arrive together
+        std::uint64_t frame;
         CursorButton button;
         InputState state;
         InputModifier modifier;
@@ -310,6 +436,8 @@ namespace rwin
     {
         WindowEventType type;
         std::uint64_t windowId;
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
         int focused;
     };
 
@@ -318,14 +446,101 @@ namespace rwin
     {
         WindowEventType type;
         std::uint64_t windowId;
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
+    };
+
+    // The platform wants a new frame for the window, answers RequestFrame
+    struct FrameReadyEvent
+    {
+        WindowEventType type;
+        std::uint64_t windowId;
+        // When the compositor asked for the frame, on Wayland the time of the callback
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
+    };
+
+    // When a frame committed after RequestFrame reached the screen
+    struct PresentedEvent
+    {
+        WindowEventType type;
+        std::uint64_t windowId;
+        // Time the frame turned visible, 0 when it was discarded
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
+        // Nanoseconds between refreshes of the output, 0 when it has no fixed rate
+        std::uint32_t refresh;
+        // Vertical blank counter of the output, 0 when it has none
+        std::uint64_t msc;
+        PresentFlags flags;
+    };
 
+    // The window's scale changed, usually because it moved to another output, dpi is the new GetDpi
+    struct ScaleChangedEvent
+    {
+        WindowEventType type;
+        std::uint64_t windowId;
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
+        float scale;
+        float dpi;
+    };
+
+    struct StateChangedEvent
+    {
+        WindowEventType type;
+        std::uint64_t windowId;
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
+        WindowState state;
+        WindowState previous;
+    };
+
+    // Renderers can stop drawing while the window is not visible, hidden, suspended or not yet mapped
+    struct VisibilityChangedEvent
+    {
+        WindowEventType type;
+        std::uint64_t windowId;
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
+        bool visible;
     };
 
     struct TextEvent
     {
         WindowEventType type;
         std::uint64_t windowId;
-        char16_t text;
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
+        // UTF-8 without a terminator, owned by the window's event queue and valid until the next pump that starts with
+        // that queue drained
+        const char* text;
+        std::uint32_t length;
+
+        [[nodiscard]] std::string_view View() const
+        {
+            return {text, length};
+        }
+    };
+
+    // Text an input method is composing, an empty text ends the composition
+    struct CompositionEvent
+    {
+        WindowEventType type;
+        std::uint64_t windowId;
+        std::uint64_t timestamp;
+        std::uint64_t sequence;
+        // Same storage and lifetime as TextEvent::text
+        const char* text;
+        std::uint32_t length;
+        // Byte offsets of the cursor inside text, both -1 when the cursor should be hidden
+        std::int32_t cursorBegin;
+        std::int32_t cursorEnd;
+
+        [[nodiscard]] std::string_view View() const
+        {
+            return {text, length};
+        }
     };
 
     struct WindowEvent
@@ -344,6 +559,37 @@ namespace rwin
             FocusEvent keyboardFocus;
             CloseEvent close;
             TextEvent text;
+            CompositionEvent composition;
+            RawMotionEvent rawMotion;
+            FrameReadyEvent frameReady;
+            PresentedEvent presented;
+            ScaleChangedEvent scaleChanged;
+            StateChangedEvent stateChanged;
+            VisibilityChangedEvent visibilityChanged;
         };
     };
+
+    // Polled input state of a window, the backends update it as input arrives
+    struct InputSnapshot
+    {
+        static constexpr std::size_t KeyCount = static_cast<std::size_t>(InputKey::Menu) + 1;
+
+        std::bitset<KeyCount> keys{};
+        // Bit n is set while CursorButton n is held
+        std::uint32_t buttons{};
+        Vector2 cursorPosition{};
+        // Sum of the scroll deltas the last pump delivered, positive is down and right
+        Vector2 scrollDelta{};
+        InputModifier modifiers{};
+
+        [[nodiscard]] bool IsKeyDown(const InputKey& key) const
+        {
+            return keys.test(static_cast<std::size_t>(key));
+        }
+
+        [[nodiscard]] bool IsButtonDown(const CursorButton& button) const
+        {
+            return (buttons & 1u << static_cast<std::uint32_t>(button)) != 0;
+        }
+    };
 }
\ No newline at end of file
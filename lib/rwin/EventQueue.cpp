@@ -0,0 +1,254 @@
+﻿#include "rwin/EventQueue.h"
+#include <algorithm>
+#include <bit>
+#include <limits>
+namespace rwin
+{
+    EventQueue::EventQueue(const std::size_t capacity)
+    {
+        _events.resize(std::bit_ceil(std::max<std::size_t>(capacity, 1)));
+        _mask = _events.size() - 1;
+    }
+
+    void EventQueue::Push(const WindowEvent& event)
+    {
+        const auto motion = event.info.type == WindowEventType::CursorMove && _coalescing != MotionCoalescing::None;
+        if (motion)
+        {
+            _motionHistory.push_back(MotionSample{event.cursorMove.position, event.cursorMove.timestamp});
+        }
+
+        if (TryCoalesce(event))
+        {
+            return;
+        }
+
+        if (_size == _events.size())
+        {
+            Grow();
+        }
+
+        _events[(_head + _size) & _mask] = event;
+        _size++;
+        if (motion)
+        {
+            Back().cursorMove.historyOffset = _historyBase + static_cast<std::uint32_t>(_motionHistory.size() - 1);
+        }
+    }
+
+    void EventQueue::SetMotionCoalescing(const MotionCoalescing& coalescing)
+    {
+        _coalescing = coalescing;
+    }
+
+    WindowEvent& EventQueue::Back()
+    {
+        return _events[(_head + _size - 1) & _mask];
+    }
+
+    std::span<const WindowEvent> EventQueue::Peek() const
+    {
+        const auto contiguous = std::min(_size, _events.size() - _head);
+        return {_events.data() + _head, contiguous};
+    }
+
+    void EventQueue::Consume(const std::size_t count)
+    {
+        const auto consumed = std::min(count, _size);
+        _head = (_head + consumed) & _mask;
+        _size -= consumed;
+        if (_size == 0)
+        {
+            _head = 0;
+        }
+    }
+
+    std::uint64_t EventQueue::Pop(const std::span<WindowEvent>& events)
+    {
+        std::size_t gotten = 0;
+        while (gotten < events.size() && !Empty())
+        {
+            const auto front = Peek();
+            const auto count = std::min(front.size(), events.size() - gotten);
+            std::copy_n(front.begin(), count, events.begin() + static_cast<std::ptrdiff_t>(gotten));
+            Consume(count);
+            gotten += count;
+        }
+        return gotten;
+    }
+
+    std::size_t EventQueue::Size() const
+    {
+        return _size;
+    }
+
+    bool EventQueue::Empty() const
+    {
+        return _size == 0;
+    }
+
+    void EventQueue::Clear()
+    {
+        _head = 0;
+        _size = 0;
+        _historyBase += static_cast<std::uint32_t>(_motionHistory.size());
+        _motionHistory.clear();
+    }
+
+    std::span<const MotionSample> EventQueue::GetMotionHistory(const CursorMoveEvent& event) const
+    {
+        // Offsets below the base wrap around to huge starts, their samples were released
+        const std::uint64_t start = event.historyOffset - _historyBase;
+        if (event.samples == 0 || start + event.samples > _motionHistory.size())
+        {
+            return {};
+        }
+
+        // A run always ends with the sample of the event itself, anything else is an event that never had a history
+        const auto run = std::span{_motionHistory}.subspan(start, event.samples);
+        if (run.back().timestamp != event.timestamp)
+        {
+            return {};
+        }
+        return run;
+    }
+
+    void EventQueue::ReleaseHistory()
+    {
+        // Queued motion is in push order so the first CursorMove holds the oldest samples still needed
+        auto keep = _historyBase + static_cast<std::uint32_t>(_motionHistory.size());
+        for (std::size_t i = 0; i < _size; i++)
+        {
+            if (const auto& event = _events[(_head + i) & _mask]; event.info.type == WindowEventType::CursorMove &&
+                GetMotionHistory(event.cursorMove).size() != 0)
+            {
+                keep = event.cursorMove.historyOffset;
+                break;
+            }
+        }
+
+        const auto released = keep - _historyBase;
+        _motionHistory.erase(_motionHistory.begin(), _motionHistory.begin() + released);
+        _historyBase = keep;
+    }
+
+    std::string_view EventQueue::StoreText(const std::string_view& text)
+    {
+        return _text.Store(text);
+    }
+
+    void EventQueue::ReleaseText()
+    {
+        if (Empty())
+        {
+            _text.Clear();
+        }
+    }
+
+    std::size_t EventQueue::TextSize() const
+    {
+        return _text.Size();
+    }
+
+    bool EventQueue::TryCoalesce(const WindowEvent& event)
+    {
+        if (_coalescing == MotionCoalescing::None || event.info.type != WindowEventType::CursorMove || Empty())
+        {
+            return false;
+        }
+
+        auto& back = Back();
+        if (back.info.type != WindowEventType::CursorMove || back.info.windowId != event.info.windowId)
+        {
+            return false;
+        }
+
+        // The back's run has to end right before the sample just recorded, it has none when pushed while coalescing was off
+        const auto newest = _historyBase + static_cast<std::uint32_t>(_motionHistory.size() - 1);
+        if (back.cursorMove.historyOffset + back.cursorMove.samples != newest || GetMotionHistory(back.cursorMove).empty())
+        {
+            return false;
+        }
+
+        const auto samples = back.cursorMove.samples + event.cursorMove.samples;
+        const auto delta = back.cursorMove.delta;
+        const auto historyOffset = back.cursorMove.historyOffset;
+        back = event;
+        back.cursorMove.samples = samples;
+        // Samples of one window are pushed back to back so the merged run stays contiguous in the history
+        back.cursorMove.historyOffset = historyOffset;
+        if (_coalescing == MotionCoalescing::LatestWithDelta)
+        {
+            back.cursorMove.delta.x += delta.x;
+            back.cursorMove.delta.y += delta.y;
+        }
+        return true;
+    }
+
+    void EventQueue::Grow()
+    {
+        std::vector<WindowEvent> events{};
+        events.resize(_events.size() * 2);
+        const auto front = Peek();
+        const auto wrapped = std::copy(front.begin(), front.end(), events.begin());
+        std::copy_n(_events.begin(), _size - front.size(), wrapped);
+        _events = std::move(events);
+        _mask = _events.size() - 1;
+        _head = 0;
+    }
+
+    EventQueue* FindOldestRun(const std::span<EventQueue* const>& queues, std::size_t& count)
+    {
+        count = 0;
+        EventQueue* oldest = nullptr;
+        auto oldestSequence = std::numeric_limits<std::uint64_t>::max();
+        auto nextSequence = std::numeric_limits<std::uint64_t>::max();
+        for (const auto queue : queues)
+        {
+            if (queue->Empty())
+            {
+                continue;
+            }
+
+            const auto sequence = queue->Peek().front().info.sequence;
+            if (sequence < oldestSequence)
+            {
+                nextSequence = oldestSequence;
+                oldestSequence = sequence;
+                oldest = queue;
+            }
+            else if (sequence < nextSequence)
+            {
+                nextSequence = sequence;
+            }
+        }
+
+        if (oldest != nullptr)
+        {
+            // Sequences only grow within a queue so the run ends at the first event newer than the next queue's front
+            const auto front = oldest->Peek();
+            const auto end = std::ranges::partition_point(front, [nextSequence](const WindowEvent& event)
+            {
+                return event.info.sequence < nextSequence;
+            });
+            count = static_cast<std::size_t>(end - front.begin());
+        }
+        return oldest;
+    }
+
+    std::uint64_t PopOrdered(const std::span<EventQueue* const>& queues, const std::span<WindowEvent>& events)
+    {
+        std::uint64_t gotten = 0;
+        std::size_t count = 0;
+        while (gotten < events.size())
+        {
+            const auto queue = FindOldestRun(queues, count);
+            if (queue == nullptr)
+            {
+                break;
+            }
+            gotten += queue->Pop(events.subspan(gotten, std::min<std::size_t>(count, events.size() - gotten)));
+        }
+        return gotten;
+    }
+}
@@ -0,0 +1,51 @@
+#include "rwin/TextArena.h"
+#include <algorithm>
+#include <cstring>
+namespace rwin
+{
+    TextArena::TextArena(const std::size_t chunkSize) : _chunkSize(std::max<std::size_t>(chunkSize, 1))
+    {
+    }
+
+    std::string_view TextArena::Store(const std::string_view& text)
+    {
+        if (text.empty())
+        {
+            return {};
+        }
+
+        while (_current < _chunks.size() && _chunks[_current].capacity - _used < text.size())
+        {
+            _current++;
+            _used = 0;
+        }
+
+        if (_current == _chunks.size())
+        {
+            const auto capacity = std::max(_chunkSize, text.size());
+            _chunks.push_back(Chunk{std::make_unique<char[]>(capacity), capacity});
+        }
+
+        const auto data = _chunks[_current].data.get() + _used;
+        std::memcpy(data, text.data(), text.size());
+        _used += text.size();
+        _size += text.size();
+        return {data, text.size()};
+    }
+
+    void TextArena::Clear()
+    {
+        std::erase_if(_chunks, [this](const Chunk& chunk)
+        {
+            return chunk.capacity != _chunkSize;
+        });
+        _current = 0;
+        _used = 0;
+        _size = 0;
+    }
+
+    std::size_t TextArena::Size() const
+    {
+        return _size;
+    }
+}
@@ -0,0 +1,166 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <xkbcommon/xkbcommon.h>
+#include "rwin/types.h"
+namespace rwin
+{
+    struct KeysymMapping
+    {
+        xkb_keysym_t keysym;
+        InputKey key;
+    };
+
+    // Letters, digits and F1 to F24 are contiguous in both enums and are filled in by makeKeysymTables
+    constexpr KeysymMapping KEYSYM_MAPPINGS[] = {
+        {XKB_KEY_space, InputKey::Space},
+        {XKB_KEY_apostrophe, InputKey::Apostrophe},
+        {XKB_KEY_comma, InputKey::Comma},
+        {XKB_KEY_minus, InputKey::Minus},
+        {XKB_KEY_period, InputKey::Period},
+        {XKB_KEY_slash, InputKey::Slash},
+        {XKB_KEY_semicolon, InputKey::Semicolon},
+        {XKB_KEY_equal, InputKey::Equal},
+        {XKB_KEY_bracketleft, InputKey::LeftBracket},
+        {XKB_KEY_backslash, InputKey::Backslash},
+        {XKB_KEY_bracketright, InputKey::RightBracket},
+        {XKB_KEY_grave, InputKey::GraveAccent},
+
+        {XKB_KEY_Escape, InputKey::Escape},
+        {XKB_KEY_Return, InputKey::Enter},
+        {XKB_KEY_Tab, InputKey::Tab},
+        {XKB_KEY_BackSpace, InputKey::Backspace},
+        {XKB_KEY_Insert, InputKey::Insert},
+        {XKB_KEY_Delete, InputKey::Delete},
+        {XKB_KEY_Right, InputKey::Right},
+        {XKB_KEY_Left, InputKey::Left},
+        {XKB_KEY_Down, InputKey::Down},
+        {XKB_KEY_Up, InputKey::Up},
+        {XKB_KEY_Page_Up, InputKey::PageUp},
+        {XKB_KEY_Page_Down, InputKey::PageDown},
+        {XKB_KEY_Home, InputKey::Home},
+        {XKB_KEY_End, InputKey::End},
+
+        {XKB_KEY_Caps_Lock, InputKey::CapsLock},
+        {XKB_KEY_Scroll_Lock, InputKey::ScrollLock},
+        {XKB_KEY_Num_Lock, InputKey::NumLock},
+        {XKB_KEY_Print, InputKey::PrintScreen},
+        {XKB_KEY_Pause, InputKey::Pause},
+
+        {XKB_KEY_Shift_L, InputKey::LeftShift},
+        {XKB_KEY_Shift_R, InputKey::RightShift},
+        {XKB_KEY_Control_L, InputKey::LeftControl},
+        {XKB_KEY_Control_R, InputKey::RightControl},
+        {XKB_KEY_Alt_L, InputKey::LeftAlt},
+        {XKB_KEY_Alt_R, InputKey::RightAlt},
+        {XKB_KEY_Super_L, InputKey::LeftSuper},
+        {XKB_KEY_Super_R, InputKey::RightSuper},
+        {XKB_KEY_Menu, InputKey::Menu},
+    };
+
+    // Keysyms outside the two dense pages, sorted by keysym
+    constexpr KeysymMapping SPARSE_KEYSYM_MAPPINGS[] = {
+        // AltGr on most layouts
+        {XKB_KEY_ISO_Level3_Shift, InputKey::RightAlt},
+        // What Tab produces while shift is held
+        {XKB_KEY_ISO_Left_Tab, InputKey::Tab},
+    };
+
+    // Every mapped keysym is in the latin 1 page (0x00xx) or the function key page (0xffxx), each is a direct index
+    struct KeysymTables
+    {
+        std::array<InputKey, 256> latin1{};
+        std::array<InputKey, 256> function{};
+    };
+
+    constexpr bool isLatin1Keysym(const xkb_keysym_t keysym)
+    {
+        return keysym <= 0xff;
+    }
+
+    constexpr bool isFunctionKeysym(const xkb_keysym_t keysym)
+    {
+        return (keysym & ~0xffu) == 0xff00;
+    }
+
+    constexpr KeysymTables makeKeysymTables()
+    {
+        KeysymTables tables{};
+        for (std::uint32_t i = 0; i < 26; i++)
+        {
+            const auto key = static_cast<InputKey>(static_cast<std::uint32_t>(InputKey::A) + i);
+            tables.latin1[XKB_KEY_A + i] = key;
+            tables.latin1[XKB_KEY_a + i] = key;
+        }
+
+        for (std::uint32_t i = 0; i < 10; i++)
+        {
+            tables.latin1[XKB_KEY_0 + i] = static_cast<InputKey>(static_cast<std::uint32_t>(InputKey::Zero) + i);
+        }
+
+        for (std::uint32_t i = 0; i < 24; i++)
+        {
+            tables.function[(XKB_KEY_F1 + i) & 0xff] = static_cast<InputKey>(static_cast<std::uint32_t>(InputKey::F1) + i);
+        }
+
+        for (const auto& mapping : KEYSYM_MAPPINGS)
+        {
+            (isLatin1Keysym(mapping.keysym) ? tables.latin1 : tables.function)[mapping.keysym & 0xff] = mapping.key;
+        }
+        return tables;
+    }
+
+    constexpr KeysymTables KEYSYM_TABLES = makeKeysymTables();
+
+    constexpr InputKey lookupKeysym(const xkb_keysym_t keysym)
+    {
+        if (isLatin1Keysym(keysym))
+        {
+            return KEYSYM_TABLES.latin1[keysym];
+        }
+
+        if (isFunctionKeysym(keysym))
+        {
+            return KEYSYM_TABLES.function[keysym & 0xff];
+        }
+
+        const auto found = std::ranges::lower_bound(SPARSE_KEYSYM_MAPPINGS, keysym, {}, &KeysymMapping::keysym);
+        return found != std::end(SPARSE_KEYSYM_MAPPINGS) && found->keysym == keysym ? found->key : InputKey::Unknown;
+    }
+
+    constexpr bool keysymTablesMatchMappings()
+    {
+        for (const auto& mapping : KEYSYM_MAPPINGS)
+        {
+            if (!(isLatin1Keysym(mapping.keysym) || isFunctionKeysym(mapping.keysym)) || lookupKeysym(mapping.keysym) != mapping.key)
+            {
+                return false;
+            }
+        }
+
+        for (const auto& mapping : SPARSE_KEYSYM_MAPPINGS)
+        {
+            if (lookupKeysym(mapping.keysym) != mapping.key)
+            {
+                return false;
+            }
+        }
+
+        for (std::uint32_t i = 0; i < 26; i++)
+        {
+            if (lookupKeysym(XKB_KEY_A + i) != lookupKeysym(XKB_KEY_a + i))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(std::ranges::is_sorted(SPARSE_KEYSYM_MAPPINGS, {}, &KeysymMapping::keysym));
+    static_assert(keysymTablesMatchMappings());
+    static_assert(lookupKeysym(XKB_KEY_w) == InputKey::W && lookupKeysym(XKB_KEY_Z) == InputKey::Z);
+    static_assert(lookupKeysym(XKB_KEY_9) == InputKey::Nine && lookupKeysym(XKB_KEY_F24) == InputKey::F24);
+    static_assert(lookupKeysym(0x1008ff11) == InputKey::Unknown);
+}
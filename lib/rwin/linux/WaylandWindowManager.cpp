@@ -1,162 +1,113 @@
 ﻿#include "rwin/macros.h"
 #if defined(RWIN_PLATFORM_LINUX) && defined(RWIN_PLATFORM_LINUX_WAYLAND)
 #include "WaylandWindowManager.h"
+#include "Keysyms.h"
 
+#include <algorithm>
 #include <iostream>
 #include <ranges>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
+#include <utility>
 #include <wayland-client-protocol.h>
 #include <xdg-shell-client-protocol.h>
 #include <xdg-decoration-unstable-v1-client-protocol.h>
 #include <vulkan/vulkan_wayland.h>
 #include <sys/mman.h>
+#include <time.h>
 #include <linux/input-event-codes.h>
 
 namespace rwin
 {
-#define UINT64_NULL_HANDLE std::numeric_limits<std::uint64_t>::max()
-
-    InputKey xkbKeyToInputKey(const xkb_keysym_t key)
-    {
-        switch (key)
-        {
-        case XKB_KEY_A:
-        case XKB_KEY_a: return InputKey::A;
-        case XKB_KEY_B:
-        case XKB_KEY_b: return InputKey::B;
-        case XKB_KEY_C:
-        case XKB_KEY_c: return InputKey::C;
-        case XKB_KEY_D:
-        case XKB_KEY_d: return InputKey::D;
-        case XKB_KEY_E:
-        case XKB_KEY_e: return InputKey::E;
-        case XKB_KEY_F:
-        case XKB_KEY_f: return InputKey::F;
-        case XKB_KEY_G:
-        case XKB_KEY_g: return InputKey::G;
-        case XKB_KEY_H:
-        case XKB_KEY_h: return InputKey::H;
-        case XKB_KEY_I:
-        case XKB_KEY_i: return InputKey::I;
-        case XKB_KEY_J:
-        case XKB_KEY_j: return InputKey::J;
-        case XKB_KEY_K:
-        case XKB_KEY_k: return InputKey::K;
-        case XKB_KEY_L:
-        case XKB_KEY_l: return InputKey::L;
-        case XKB_KEY_M:
-        case XKB_KEY_m: return InputKey::M;
-        case XKB_KEY_N:
-        case XKB_KEY_n: return InputKey::N;
-        case XKB_KEY_O:
-        case XKB_KEY_o: return InputKey::O;
-        case XKB_KEY_P:
-        case XKB_KEY_p: return InputKey::P;
-        case XKB_KEY_Q:
-        case XKB_KEY_q: return InputKey::Q;
-        case XKB_KEY_R:
-        case XKB_KEY_r: return InputKey::R;
-        case XKB_KEY_S:
-        case XKB_KEY_s: return InputKey::S;
-        case XKB_KEY_T:
-        case XKB_KEY_t: return InputKey::T;
-        case XKB_KEY_U:
-        case XKB_KEY_u: return InputKey::U;
-        case XKB_KEY_V:
-        case XKB_KEY_v: return InputKey::V;
-        case XKB_KEY_W:
-        case XKB_KEY_w: return InputKey::W;
-        case XKB_KEY_X:
-        case XKB_KEY_x: return InputKey::X;
-        case XKB_KEY_Y:
-        case XKB_KEY_y: return InputKey::Y;
-        case XKB_KEY_Z:
-        case XKB_KEY_z: return InputKey::Z;
-
-        case XKB_KEY_0: return InputKey::Zero;
-        case XKB_KEY_1: return InputKey::One;
-        case XKB_KEY_2: return InputKey::Two;
-        case XKB_KEY_3: return InputKey::Three;
-        case XKB_KEY_4: return InputKey::Four;
-        case XKB_KEY_5: return InputKey::Five;
-        case XKB_KEY_6: return InputKey::Six;
-        case XKB_KEY_7: return InputKey::Seven;
-        case XKB_KEY_8: return InputKey::Eight;
-        case XKB_KEY_9: return InputKey::Nine;
-
-        case XKB_KEY_F1: return InputKey::F1;
-        case XKB_KEY_F2: return InputKey::F2;
-        case XKB_KEY_F3: return InputKey::F3;
-        case XKB_KEY_F4: return InputKey::F4;
-        case XKB_KEY_F5: return InputKey::F5;
-        case XKB_KEY_F6: return InputKey::F6;
-        case XKB_KEY_F7: return InputKey::F7;
-        case XKB_KEY_F8: return InputKey::F8;
-        case XKB_KEY_F9: return InputKey::F9;
-        case XKB_KEY_F10: return InputKey::F10;
-        case XKB_KEY_F11: return InputKey::F11;
-        case XKB_KEY_F12: return InputKey::F12;
-        case XKB_KEY_F13: return InputKey::F13;
-        case XKB_KEY_F14: return InputKey::F14;
-        case XKB_KEY_F15: return InputKey::F15;
-        case XKB_KEY_F16: return InputKey::F16;
-        case XKB_KEY_F17: return InputKey::F17;
-        case XKB_KEY_F18: return InputKey::F18;
-        case XKB_KEY_F19: return InputKey::F19;
-        case XKB_KEY_F20: return InputKey::F20;
-        case XKB_KEY_F21: return InputKey::F21;
-        case XKB_KEY_F22: return InputKey::F22;
-        case XKB_KEY_F23: return InputKey::F23;
-        case XKB_KEY_F24: return InputKey::F24;
-
-        case XKB_KEY_space: return InputKey::Space;
-        case XKB_KEY_apostrophe: return InputKey::Apostrophe;
-        case XKB_KEY_comma: return InputKey::Comma;
-        case XKB_KEY_minus: return InputKey::Minus;
-        case XKB_KEY_period: return InputKey::Period;
-        case XKB_KEY_slash: return InputKey::Slash;
-        case XKB_KEY_semicolon: return InputKey::Semicolon;
-        case XKB_KEY_equal: return InputKey::Equal;
-        case XKB_KEY_bracketleft: return InputKey::LeftBracket;
-        case XKB_KEY_backslash: return InputKey::Backslash;
-        case XKB_KEY_bracketright: return InputKey::RightBracket;
-        case XKB_KEY_grave: return InputKey::GraveAccent;
-
-        case XKB_KEY_Escape: return InputKey::Escape;
-        case XKB_KEY_Return: return InputKey::Enter;
-        case XKB_KEY_Tab: return InputKey::Tab;
-        case XKB_KEY_BackSpace: return InputKey::Backspace;
-        case XKB_KEY_Insert: return InputKey::Insert;
-        case XKB_KEY_Delete: return InputKey::Delete;
-        case XKB_KEY_Right: return InputKey::Right;
-        case XKB_KEY_Left: return InputKey::Left;
-        case XKB_KEY_Down: return InputKey::Down;
-        case XKB_KEY_Up: return InputKey::Up;
-        case XKB_KEY_Page_Up: return InputKey::PageUp;
-        case XKB_KEY_Page_Down: return InputKey::PageDown;
-        case XKB_KEY_Home: return InputKey::Home;
-        case XKB_KEY_End: return InputKey::End;
-
-        case XKB_KEY_Caps_Lock: return InputKey::CapsLock;
-        case XKB_KEY_Scroll_Lock: return InputKey::ScrollLock;
-        case XKB_KEY_Num_Lock: return InputKey::NumLock;
-        case XKB_KEY_Print: return InputKey::PrintScreen;
-        case XKB_KEY_Pause: return InputKey::Pause;
-
-        case XKB_KEY_Shift_L: return InputKey::LeftShift;
-        case XKB_KEY_Shift_R: return InputKey::RightShift;
-        case XKB_KEY_Control_L: return InputKey::LeftControl;
-        case XKB_KEY_Control_R: return InputKey::RightControl;
-        case XKB_KEY_Alt_L: return InputKey::LeftAlt;
-        case XKB_KEY_Alt_R: return InputKey::RightAlt;
-        case XKB_KEY_Super_L: return InputKey::LeftSuper;
-        case XKB_KEY_Super_R: return InputKey::RightSuper;
-        case XKB_KEY_Menu: return InputKey::Menu;
-
-        default:
-            std::cerr << "Unknown keysym: " << key << std::endl;
-            return InputKey::Unknown;
+    // Marks surfaces created by Create, libdecor's decoration surfaces carry user data of their own
+    const char* const SURFACE_TAG = "rwin_window";
+
+    const char* const APP_ID = "rin_app";
+
+    thread_local bool ON_INPUT_THREAD = false;
+
+    WindowState toWindowState(const libdecor_window_state& windowState)
+    {
+        std::uint32_t state = 0;
+        if (windowState & LIBDECOR_WINDOW_STATE_ACTIVE) state |= static_cast<std::uint32_t>(WindowState::Active);
+        if (windowState & LIBDECOR_WINDOW_STATE_MAXIMIZED) state |= static_cast<std::uint32_t>(WindowState::Maximized);
+        if (windowState & LIBDECOR_WINDOW_STATE_FULLSCREEN) state |= static_cast<std::uint32_t>(WindowState::Fullscreen);
+        if (windowState & (LIBDECOR_WINDOW_STATE_TILED_LEFT | LIBDECOR_WINDOW_STATE_TILED_RIGHT |
+                           LIBDECOR_WINDOW_STATE_TILED_TOP | LIBDECOR_WINDOW_STATE_TILED_BOTTOM))
+        {
+            state |= static_cast<std::uint32_t>(WindowState::Tiled);
+        }
+        if (windowState & LIBDECOR_WINDOW_STATE_SUSPENDED) state |= static_cast<std::uint32_t>(WindowState::Suspended);
+        return static_cast<WindowState>(state);
+    }
+
+    void releaseOutput(wl_output* output)
+    {
+        if (wl_proxy_get_version(reinterpret_cast<wl_proxy*>(output)) >= WL_OUTPUT_RELEASE_SINCE_VERSION)
+        {
+            wl_output_release(output);
+        }
+        else
+        {
+            wl_output_destroy(output);
+        }
+    }
+
+    std::uint64_t monotonicTime()
+    {
+        timespec now{};
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return static_cast<std::uint64_t>(now.tv_sec) * 1000000000 + static_cast<std::uint64_t>(now.tv_nsec);
+    }
+
+    // Adds to one axis of a scroll vector, wayland's axis values are positive down and right like ours
+    void addAxis(Vector2& vector, const uint32_t axis, const float amount)
+    {
+        (axis == WL_POINTER_AXIS_HORIZONTAL_SCROLL ? vector.x : vector.y) += amount;
+    }
+
+    void watchFd(const int epoll, const int fd)
+    {
+        epoll_event event{.events = EPOLLIN, .data = {.fd = fd}};
+        epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    // Presentation times are on the clock the compositor announced, other timestamps are on CLOCK_MONOTONIC
+    std::uint64_t toMonotonicTime(const clockid_t clock, const std::uint64_t time)
+    {
+        if (clock == CLOCK_MONOTONIC)
+        {
+            return time;
+        }
+
+        timespec now{};
+        clock_gettime(clock, &now);
+        const auto clockNow = static_cast<std::uint64_t>(now.tv_sec) * 1000000000 + static_cast<std::uint64_t>(now.tv_nsec);
+        return time + monotonicTime() - clockNow;
+    }
+
+    // Millisecond protocol times have an undefined base, without zwp_input_timestamps events take their arrival time
+    std::uint64_t takeInputTimestamp(std::uint64_t& precise)
+    {
+        if (precise != 0)
+        {
+            return std::exchange(precise, 0);
         }
+        return monotonicTime();
+    }
+
+    // Enter, Tab, Backspace and control chords produce control characters, those are left to key events
+    bool isPrintable(const std::string_view& text)
+    {
+        return !text.empty() && !(text.size() == 1 && (static_cast<unsigned char>(text.front()) < 0x20 || text.front() == 0x7f));
+    }
+
+    bool carriesText(const WindowEvent& event)
+    {
+        return event.info.type == WindowEventType::Text || event.info.type == WindowEventType::Composition;
     }
 
     Flags<InputModifier> getInputModifiers(xkb_state* state)
@@ -203,16 +154,11 @@ namespace rwin
             {
                 if (auto self = static_cast<WaylandWindowManager*>(data))
                 {
-                    if (auto ptr = self->_keyboards.find(wl_keyboard); ptr != self->_keyboards.end())
-                    {
-                        self->_keyboards.erase(ptr);
-                    }
-
                     const auto keymapString = static_cast<char*>(mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0));
+                    self->StopRepeat();
 
-                    self->_keyboards.emplace(wl_keyboard,
-                                             std::make_shared<KeyboardInfo>(
-                                                 self->_xkbContext, keymapString, XKB_KEYMAP_FORMAT_TEXT_V1));
+                    self->_keyboardInfo = std::make_unique<KeyboardInfo>(
+                        self->_xkbContext, keymapString, XKB_KEYMAP_FORMAT_TEXT_V1);
                     munmap(keymapString, size);
                     close(fd);
                 }
@@ -227,14 +173,28 @@ namespace rwin
                 {
                     if (const auto info = self->GetWindowInfo(surface))
                     {
-                        self->_keyboardFocusedHandle = info->windowId;
+                        self->_keyboardFocus = info;
+                        if (const auto keyboard = self->_keyboardInfo.get())
+                        {
+                            // Keys already held when focus arrives
+                            const auto pressed = static_cast<const uint32_t*>(keys->data);
+                            for (std::size_t i = 0; i < keys->size / sizeof(uint32_t); i++)
+                            {
+                                const auto key = lookupKeysym(xkb_state_key_get_one_sym(keyboard->state, pressed[i] + 8));
+                                keyboard->heldKeys[pressed[i] + 8] = key;
+                                info->input.keys.set(static_cast<std::size_t>(key));
+                            }
+                            info->input.modifiers = static_cast<InputModifier>(getInputModifiers(keyboard->state));
+                        }
+                        if (!info->Accepts(WindowEventType::KeyboardFocus)) return;
                         WindowEvent ev{};
                         new(&ev.keyboardFocus) FocusEvent{
                             .type = WindowEventType::KeyboardFocus,
                             .windowId = info->windowId,
+                            .timestamp = monotonicTime(),
                             .focused = 1,
                         };
-                        self->_pendingEvents.push_back(ev);
+                        self->PushEvent(ev);
                     }
                 }
             },
@@ -247,14 +207,23 @@ namespace rwin
                 {
                     if (const auto info = self->GetWindowInfo(surface))
                     {
-                        self->_keyboardFocusedHandle = UINT64_NULL_HANDLE;
+                        self->StopRepeat();
+                        self->_keyboardFocus = nullptr;
+                        info->input.keys.reset();
+                        info->input.modifiers = {};
+                        if (const auto keyboard = self->_keyboardInfo.get())
+                        {
+                            keyboard->heldKeys.clear();
+                        }
+                        if (!info->Accepts(WindowEventType::KeyboardFocus)) return;
                         WindowEvent ev{};
                         new(&ev.keyboardFocus) FocusEvent{
                             .type = WindowEventType::KeyboardFocus,
                             .windowId = info->windowId,
+                            .timestamp = monotonicTime(),
                             .focused = 0
                         };
-                        self->_pendingEvents.push_back(ev);
+                        self->PushEvent(ev);
                     }
                 }
             },
@@ -267,12 +236,9 @@ namespace rwin
             {
                 if (auto self = static_cast<WaylandWindowManager*>(data))
                 {
-                    if (self->_keyboardFocusedHandle == UINT64_NULL_HANDLE) return;
-
-                    const auto keyboardPtr = self->_keyboards.find(wl_keyboard);
-                    if (keyboardPtr == self->_keyboards.end()) return;
-
-                    const auto keyboard = keyboardPtr->second;
+                    const auto info = self->_keyboardFocus;
+                    const auto keyboard = self->_keyboardInfo.get();
+                    if (info == nullptr || keyboard == nullptr) return;
 
                     InputState inputState{};
                     xkb_key_direction direction{};
@@ -288,33 +254,64 @@ namespace rwin
                     }
 
                     const auto keyCode = key + 8;
+                    const auto timestamp = takeInputTimestamp(self->_keyboardTimestamp);
+                    // Repeats that came due before this key changed state go out first
+                    self->EmitRepeats(timestamp);
                     xkb_state_update_key(keyboard->state, keyCode, direction);
 
-                    const auto xkbKey = xkb_state_key_get_one_sym(keyboard->state, keyCode);
-                    const auto rinKey = xkbKeyToInputKey(xkbKey);
+                    auto rinKey = lookupKeysym(xkb_state_key_get_one_sym(keyboard->state, keyCode));
+                    if (const auto pressed = keyboard->heldKeys.find(keyCode); pressed != keyboard->heldKeys.end())
+                    {
+                        rinKey = pressed->second;
+                        if (inputState == InputState::Pressed)
+                        {
+                            inputState = InputState::Repeat;
+                        }
+                    }
 
-                    if (keyboard->keysPressed.contains(rinKey) && inputState == InputState::Pressed)
+                    const auto held = inputState != InputState::Released;
+                    if (held)
+                    {
+                        keyboard->heldKeys[keyCode] = rinKey;
+                    }
+                    else
                     {
-                        inputState = InputState::Repeat;
+                        keyboard->heldKeys.erase(keyCode);
                     }
+                    info->input.keys.set(static_cast<std::size_t>(rinKey), held);
                     const auto modifiers = getInputModifiers(keyboard->state);
-                    WindowEvent ev{};
-                    new(&ev.key) KeyEvent{
-                        .type = WindowEventType::Key,
-                        .windowId = self->_keyboardFocusedHandle,
-                        .key = rinKey,
-                        .state = inputState,
-                        .modifier = static_cast<InputModifier>(modifiers)
-                    };
-                    self->_pendingEvents.push_back(ev);
+                    info->input.modifiers = static_cast<InputModifier>(modifiers);
+                    if (inputState == InputState::Pressed && xkb_keymap_key_repeats(keyboard->keymap, keyCode))
+                    {
+                        self->StartRepeat(keyCode, rinKey, timestamp);
+                    }
+                    else if (inputState == InputState::Released && keyCode == self->_repeatKeyCode)
+                    {
+                        self->StopRepeat();
+                    }
 
-                    if (keyboard->keysPressed.contains(rinKey) && inputState == InputState::Released)
+                    if (info->Accepts(WindowEventType::Key))
                     {
-                        keyboard->keysPressed.erase(rinKey);
+                        WindowEvent ev{};
+                        new(&ev.key) KeyEvent{
+                            .type = WindowEventType::Key,
+                            .windowId = info->windowId,
+                            .timestamp = timestamp,
+                            .key = rinKey,
+                            .state = inputState,
+                            .modifier = static_cast<InputModifier>(modifiers)
+                        };
+                        self->PushEvent(ev);
                     }
-                    else
+
+                    if (held)
                     {
-                        keyboard->keysPressed.insert(rinKey);
+                        char text[64];
+                        const auto length = xkb_state_key_get_utf8(keyboard->state, keyCode, text, sizeof(text));
+                        if (const auto view = std::string_view{text, static_cast<std::size_t>(std::max(length, 0))}; isPrintable(view))
+                        {
+                            self->PushText(info, view, timestamp);
+                        }
                     }
                 }
             },
@@ -328,10 +325,15 @@ namespace rwin
             {
                 if (const auto self = static_cast<WaylandWindowManager*>(data))
                 {
-                    const auto keyboard = self->_keyboards[wl_keyboard];
-
-                    xkb_state_update_mask(keyboard->state,
-                                          mods_depressed, mods_latched, mods_locked, 0, 0, group);
+                    if (const auto keyboard = self->_keyboardInfo.get())
+                    {
+                        xkb_state_update_mask(keyboard->state,
+                                              mods_depressed, mods_latched, mods_locked, 0, 0, group);
+                        if (const auto info = self->_keyboardFocus)
+                        {
+                            info->input.modifiers = static_cast<InputModifier>(getInputModifiers(keyboard->state));
+                        }
+                    }
                 }
             },
             .repeat_info = [](void* data,
@@ -339,6 +341,16 @@ namespace rwin
                               int32_t rate,
                               int32_t delay)
             {
+                if (const auto self = static_cast<WaylandWindowManager*>(data))
+                {
+                    // A rate of 0 turns repeat off
+                    self->_repeatRate = std::max(rate, 0);
+                    self->_repeatDelay = std::max(delay, 0);
+                    if (self->_repeatRate == 0)
+                    {
+                        self->StopRepeat();
+                    }
+                }
             },
         };
 
@@ -352,16 +364,24 @@ namespace rwin
             {
                 if (const auto self = static_cast<WaylandWindowManager*>(data))
                 {
+                    // Whatever was staged for the previous surface goes out before focus moves
+                    self->FlushPointerFrame();
                     if (const auto info = self->GetWindowInfo(surface))
                     {
-                        self->_cursorFocusedHandle = info->windowId;
+                        self->_cursorFocus = info;
+                        info->input.cursorPosition = {
+                            static_cast<float>(wl_fixed_to_double(surface_x)),
+                            static_cast<float>(wl_fixed_to_double(surface_y))
+                        };
+                        if (!info->Accepts(WindowEventType::CursorFocus)) return;
                         WindowEvent ev{};
                         new(&ev.cursorFocus) FocusEvent{
                             .type = WindowEventType::CursorFocus,
                             .windowId = info->windowId,
+                            .timestamp = monotonicTime(),
                             .focused = 1,
                         };
-                        self->_pendingEvents.push_back(ev);
+                        self->PushEvent(ev);
                     }
                 }
             },
@@ -372,16 +392,21 @@ namespace rwin
             {
                 if (const auto self = static_cast<WaylandWindowManager*>(data))
                 {
+                    self->FlushPointerFrame();
                     if (const auto info = self->GetWindowInfo(surface))
                     {
-                        self->_cursorFocusedHandle = UINT64_NULL_HANDLE;
+                        self->_cursorFocus = nullptr;
+                        // Releases outside the surface are not sent to us
+                        info->input.buttons = 0;
+                        if (!info->Accepts(WindowEventType::CursorFocus)) return;
                         WindowEvent ev{};
                         new(&ev.cursorFocus) FocusEvent{
                             .type = WindowEventType::CursorFocus,
                             .windowId = info->windowId,
+                            .timestamp = monotonicTime(),
                             .focused = 0,
                         };
-                        self->_pendingEvents.push_back(ev);
+                        self->PushEvent(ev);
                     }
                 }
             },
@@ -393,19 +418,24 @@ namespace rwin
             {
                 if (const auto self = static_cast<WaylandWindowManager*>(data))
                 {
-                    if (const auto info = self->GetWindowInfo(self->_cursorFocusedHandle))
+                    if (const auto info = self->_cursorFocus)
                     {
                         const auto x = static_cast<float>(wl_fixed_to_double(surface_x));
                         const auto y = static_cast<float>(wl_fixed_to_double(surface_y));
-                        WindowEvent ev{};
-                        info->cursorPosition = {x, y};
+                        const auto delta = Vector2{x - info->input.cursorPosition.x, y - info->input.cursorPosition.y};
+                        info->input.cursorPosition = {x, y};
+                        if (!info->Accepts(WindowEventType::CursorMove)) return;
 
+                        WindowEvent ev{};
                         new(&ev.cursorMove) CursorMoveEvent{
                             .type = WindowEventType::CursorMove,
                             .windowId = info->windowId,
-                            .position = info->cursorPosition,
+                            .timestamp = takeInputTimestamp(self->_pointerTimestamp),
+                            .position = info->input.cursorPosition,
+                            .delta = delta,
+                            .samples = 1,
                         };
-                        self->_pendingEvents.push_back(ev);
+                        self->StagePointerEvent(ev);
                     }
                 }
             },
@@ -418,9 +448,8 @@ namespace rwin
             {
                 if (const auto self = static_cast<WaylandWindowManager*>(data))
                 {
-                    if (const auto info = self->GetWindowInfo(self->_cursorFocusedHandle))
+                    if (const auto info = self->_cursorFocus)
                     {
-                        WindowEvent ev{};
                         CursorButton btn;
                         switch (button)
                         {
@@ -444,14 +473,27 @@ namespace rwin
                         const InputState btnState = (state == WL_POINTER_BUTTON_STATE_PRESSED)
                                                         ? InputState::Pressed
                                                         : InputState::Released;
+                        const auto buttonBit = 1u << static_cast<std::uint32_t>(btn);
+                        if (btnState == InputState::Pressed)
+                        {
+                            info->input.buttons |= buttonBit;
+                        }
+                        else
+                        {
+                            info->input.buttons &= ~buttonBit;
+                        }
+                        if (!info->Accepts(WindowEventType::CursorButton)) return;
+
+                        WindowEvent ev{};
                         new(&ev.cursorButton) CursorButtonEvent{
                             .type = WindowEventType::CursorButton,
                             .windowId = info->windowId,
+                            .timestamp = takeInputTimestamp(self->_pointerTimestamp),
                             .button = btn,
                             .state = btnState,
                             .modifier = static_cast<InputModifier>(0),
                         };
-                        self->_pendingEvents.push_back(ev);
+                        self->StagePointerEvent(ev);
                     }
                 }
             },
@@ -461,33 +503,79 @@ namespace rwin
                        uint32_t axis,
                        wl_fixed_t value)
             {
+                if (const auto self = static_cast<WaylandWindowManager*>(data))
+                {
+                    const auto amount = static_cast<float>(wl_fixed_to_double(value));
+                    addAxis(self->_pendingScroll.delta, axis, amount);
+                    self->StageScroll(takeInputTimestamp(self->_pointerTimestamp));
+                    if (const auto info = self->_cursorFocus)
+                    {
+                        info->scroll.Add(axis == WL_POINTER_AXIS_HORIZONTAL_SCROLL ? Vector2{amount, 0} : Vector2{0, amount});
+                    }
+                }
             },
             .frame = [](void* data,
                         struct wl_pointer* wl_pointer)
             {
+                if (const auto self = static_cast<WaylandWindowManager*>(data))
+                {
+                    self->FlushPointerFrame();
+                }
             },
             .axis_source = [](void* data,
                               struct wl_pointer* wl_pointer,
                               uint32_t axis_source)
             {
+                if (const auto self = static_cast<WaylandWindowManager*>(data))
+                {
+                    switch (axis_source)
+                    {
+                    case WL_POINTER_AXIS_SOURCE_WHEEL: self->_pendingScroll.source = ScrollSource::Wheel;
+                        break;
+                    case WL_POINTER_AXIS_SOURCE_FINGER: self->_pendingScroll.source = ScrollSource::Finger;
+                        break;
+                    case WL_POINTER_AXIS_SOURCE_CONTINUOUS: self->_pendingScroll.source = ScrollSource::Continuous;
+                        break;
+                    case WL_POINTER_AXIS_SOURCE_WHEEL_TILT: self->_pendingScroll.source = ScrollSource::WheelTilt;
+                        break;
+                    default: self->_pendingScroll.source = ScrollSource::Unknown;
+                        break;
+                    }
+                }
             },
             .axis_stop = [](void* data,
                             struct wl_pointer* wl_pointer,
                             uint32_t time,
                             uint32_t axis)
             {
+                if (const auto self = static_cast<WaylandWindowManager*>(data))
+                {
+                    self->_pendingScroll.stopped |= axis == WL_POINTER_AXIS_HORIZONTAL_SCROLL
+                                                        ? ScrollAxis::Horizontal
+                                                        : ScrollAxis::Vertical;
+                    self->StageScroll(takeInputTimestamp(self->_pointerTimestamp));
+                }
             },
             .axis_discrete = [](void* data,
                                 struct wl_pointer* wl_pointer,
                                 uint32_t axis,
                                 int32_t discrete)
             {
+                // Only sent before version 8, value120 replaces it after
+                if (const auto self = static_cast<WaylandWindowManager*>(data))
+                {
+                    addAxis(self->_pendingScroll.detents, axis, static_cast<float>(discrete));
+                }
             },
             .axis_value120 = [](void* data,
                                 struct wl_pointer* wl_pointer,
                                 uint32_t axis,
                                 int32_t value120)
             {
+                if (const auto self = static_cast<WaylandWindowManager*>(data))
+                {
+                    addAxis(self->_pendingScroll.detents, axis, static_cast<float>(value120) / 120.0f);
+                }
             },
             .axis_relative_direction = [](void* data,
                                           struct wl_pointer* wl_pointer,
@@ -503,16 +591,37 @@ namespace rwin
                                uint32_t capabilities)
             {
                 auto self = static_cast<WaylandWindowManager*>(data);
-                if ((capabilities & WL_SEAT_CAPABILITY_KEYBOARD) > 0)
+                if ((capabilities & WL_SEAT_CAPABILITY_KEYBOARD) > 0 && !self->_keyboard)
                 {
                     self->_keyboard = wl_seat_get_keyboard(self->_seat);
                     wl_keyboard_add_listener(self->_keyboard, &self->_keyboardListener, self);
+                    if (self->_timestampsManager)
+                    {
+                        self->_keyboardTimestamps = zwp_input_timestamps_manager_v1_get_keyboard_timestamps(
+                            self->_timestampsManager, self->_keyboard);
+                        zwp_input_timestamps_v1_add_listener(self->_keyboardTimestamps, &self->_timestampsListener, self);
+                    }
                 }
 
-                if ((capabilities & WL_SEAT_CAPABILITY_POINTER) > 0)
+                if ((capabilities & WL_SEAT_CAPABILITY_POINTER) > 0 && !self->_pointer)
                 {
                     self->_pointer = wl_seat_get_pointer(self->_seat);
                     wl_pointer_add_listener(self->_pointer, &self->_pointerListener, self);
+                    self->_pointerFrames = wl_proxy_get_version(reinterpret_cast<wl_proxy*>(self->_pointer)) >=
+                        WL_POINTER_FRAME_SINCE_VERSION;
+                    if (self->_timestampsManager)
+                    {
+                        self->_pointerTimestamps = zwp_input_timestamps_manager_v1_get_pointer_timestamps(
+                            self->_timestampsManager, self->_pointer);
+                        zwp_input_timestamps_v1_add_listener(self->_pointerTimestamps, &self->_timestampsListener, self);
+                    }
+                    self->UpdateRelativePointer();
+                }
+
+                // Timestamp objects are created on the manager's queue and have to follow their input device
+                if (self->_inputQueue)
+                {
+                    self->MoveInputToQueue(self->_inputQueue);
                 }
             },
             .name = [](void* data,
@@ -522,6 +631,145 @@ namespace rwin
             }
         };
 
+        _relativePointerListener = {
+            .relative_motion = [](void* data,
+                                  struct zwp_relative_pointer_v1* relative_pointer,
+                                  uint32_t utime_hi,
+                                  uint32_t utime_lo,
+                                  wl_fixed_t dx,
+                                  wl_fixed_t dy,
+                                  wl_fixed_t dx_unaccel,
+                                  wl_fixed_t dy_unaccel)
+            {
+                if (const auto self = static_cast<WaylandWindowManager*>(data))
+                {
+                    const auto info = self->_cursorFocus;
+                    if (info == nullptr || !info->Accepts(WindowEventType::RawMotion)) return;
+                    // utime has an undefined base, the event takes the time of its pointer frame when that is flushed
+                    WindowEvent ev{};
+                    new(&ev.rawMotion) RawMotionEvent{
+                        .type = WindowEventType::RawMotion,
+                        .windowId = info->windowId,
+                        .delta = {
+                            static_cast<float>(wl_fixed_to_double(dx)),
+                            static_cast<float>(wl_fixed_to_double(dy))
+                        },
+                        .unaccelerated = {
+                            static_cast<float>(wl_fixed_to_double(dx_unaccel)),
+                            static_cast<float>(wl_fixed_to_double(dy_unaccel))
+                        },
+                    };
+                    self->StagePointerEvent(ev);
+                }
+            }
+        };
+
+        _timestampsListener = {
+            .timestamp = [](void* data,
+                            struct zwp_input_timestamps_v1* timestamps,
+                            uint32_t tv_sec_hi,
+                            uint32_t tv_sec_lo,
+                            uint32_t tv_nsec)
+            {
+                if (const auto self = static_cast<WaylandWindowManager*>(data))
+                {
+                    const auto seconds = (static_cast<std::uint64_t>(tv_sec_hi) << 32) | tv_sec_lo;
+                    const auto time = seconds * 1000000000 + tv_nsec;
+                    if (timestamps == self->_keyboardTimestamps)
+                    {
+                        self->_keyboardTimestamp = time;
+                    }
+                    else
+                    {
+                        self->_pointerTimestamp = time;
+                    }
+                }
+            }
+        };
+
+        _textInputListener = {
+            .enter = [](void* data,
+                        struct zwp_text_input_v3* text_input,
+                        struct wl_surface* surface)
+            {
+                if (const auto self = static_cast<WaylandWindowManager*>(data))
+                {
+                    self->_textInputFocus = self->GetWindowInfo(surface);
+                    self->UpdateTextInput(self->_textInputFocus);
+                }
+            },
+            .leave = [](void* data,
+                        struct zwp_text_input_v3* text_input,
+                        struct wl_surface* surface)
+            {
+                if (const auto self = static_cast<WaylandWindowManager*>(data))
+                {
+                    // A composition cut short by losing focus ends here
+                    if (const auto info = self->_textInputFocus; info && !self->_preedit.empty())
+                    {
+                        self->PushComposition(info, {}, -1, -1);
+                    }
+                    self->_preedit.clear();
+                    self->_textInputFocus = nullptr;
+                    self->UpdateTextInput(nullptr);
+                }
+            },
+            .preedit_string = [](void* data,
+                                 struct zwp_text_input_v3* text_input,
+                                 const char* text,
+                                 int32_t cursor_begin,
+                                 int32_t cursor_end)
+            {
+                if (const auto self = static_cast<WaylandWindowManager*>(data))
+                {
+                    self->_pendingPreedit = text ? text : "";
+                    self->_pendingPreeditBegin = cursor_begin;
+                    self->_pendingPreeditEnd = cursor_end;
+                }
+            },
+            .commit_string = [](void* data,
+                                struct zwp_text_input_v3* text_input,
+                                const char* text)
+            {
+                if (const auto self = static_cast<WaylandWindowManager*>(data))
+                {
+                    self->_pendingCommit = text ? text : "";
+                }
+            },
+            .delete_surrounding_text = [](void* data,
+                                          struct zwp_text_input_v3* text_input,
+                                          uint32_t before_length,
+                                          uint32_t after_length)
+            {
+                // We never send surrounding text so there is nothing the input method can ask us to delete
+            },
+            .done = [](void* data,
+                       struct zwp_text_input_v3* text_input,
+                       uint32_t serial)
+            {
+                if (const auto self = static_cast<WaylandWindowManager*>(data))
+                {
+                    // The commit replaces the preedit and a new preedit follows it, state not sent before done resets
+                    if (const auto info = self->_textInputFocus)
+                    {
+                        const auto timestamp = monotonicTime();
+                        self->PushText(info, self->_pendingCommit, timestamp);
+                        // Every update inside a composition is sent, as is the empty one that ends it
+                        if (!self->_pendingPreedit.empty() || !self->_preedit.empty())
+                        {
+                            self->PushComposition(info, self->_pendingPreedit, self->_pendingPreeditBegin,
+                                                  self->_pendingPreeditEnd);
+                        }
+                        self->_preedit = self->_pendingPreedit;
+                    }
+                    self->_pendingCommit.clear();
+                    self->_pendingPreedit.clear();
+                    self->_pendingPreeditBegin = -1;
+                    self->_pendingPreeditEnd = -1;
+                }
+            },
+        };
+
         _registryListener = {
             .global = [](
             void* data,
@@ -536,7 +784,7 @@ namespace rwin
 
                 if (interfaceName == wl_compositor_interface.name)
                 {
-                    const auto bindVersion = std::min<uint32_t>(version, wl_seat_interface.version);
+                    const auto bindVersion = std::min<uint32_t>(version, wl_compositor_interface.version);
                     self->_compositor = static_cast<wl_compositor*>(wl_registry_bind(
                         registry, name, &wl_compositor_interface,
                         bindVersion));
@@ -546,8 +794,76 @@ namespace rwin
                     const auto bindVersion = std::min<uint32_t>(version, wl_seat_interface.version);
                     self->_seat = static_cast<wl_seat*>(wl_registry_bind(
                         registry, name, &wl_seat_interface, bindVersion));
-                    //wl_seat_add_listener(self->_seat, &seatListener, nullptr);
+                    wl_seat_add_listener(self->_seat, &self->_seatListener, self);
+                }
+                else if (interfaceName == zwp_input_timestamps_manager_v1_interface.name)
+                {
+                    self->_timestampsManager = static_cast<zwp_input_timestamps_manager_v1*>(wl_registry_bind(
+                        registry, name, &zwp_input_timestamps_manager_v1_interface, 1));
+                }
+                else if (interfaceName == wl_output_interface.name)
+                {
+                    const auto bindVersion = std::min<uint32_t>(version, wl_output_interface.version);
+                    auto& outputInfo = self->_outputs.emplace_back(std::make_unique<OutputInfo>());
+                    outputInfo->windowManager = self;
+                    outputInfo->name = name;
+                    outputInfo->output = static_cast<wl_output*>(wl_registry_bind(
+                        registry, name, &wl_output_interface, bindVersion));
+                    wl_output_add_listener(outputInfo->output, &self->_outputListener, outputInfo.get());
+                }
+                else if (interfaceName == wp_viewporter_interface.name)
+                {
+                    self->_viewporter = static_cast<wp_viewporter*>(wl_registry_bind(
+                        registry, name, &wp_viewporter_interface, 1));
+                }
+                else if (interfaceName == wp_fractional_scale_manager_v1_interface.name)
+                {
+                    self->_fractionalScaleManager = static_cast<wp_fractional_scale_manager_v1*>(wl_registry_bind(
+                        registry, name, &wp_fractional_scale_manager_v1_interface, 1));
+                }
+                else if (interfaceName == wp_presentation_interface.name)
+                {
+                    self->_presentation = static_cast<wp_presentation*>(wl_registry_bind(
+                        registry, name, &wp_presentation_interface, 1));
+                    wp_presentation_add_listener(self->_presentation, &self->_presentationListener, self);
+                }
+                else if (interfaceName == zwp_relative_pointer_manager_v1_interface.name)
+                {
+                    self->_relativePointerManager = static_cast<zwp_relative_pointer_manager_v1*>(wl_registry_bind(
+                        registry, name, &zwp_relative_pointer_manager_v1_interface, 1));
+                }
+                else if (interfaceName == zwp_pointer_constraints_v1_interface.name)
+                {
+                    self->_pointerConstraints = static_cast<zwp_pointer_constraints_v1*>(wl_registry_bind(
+                        registry, name, &zwp_pointer_constraints_v1_interface, 1));
                 }
+                else if (interfaceName == zwp_text_input_manager_v3_interface.name)
+                {
+                    self->_textInputManager = static_cast<zwp_text_input_manager_v3*>(wl_registry_bind(
+                        registry, name, &zwp_text_input_manager_v3_interface, 1));
+                }
+            },
+            .global_remove = [](void* data,
+                                struct wl_registry* registry,
+                                uint32_t name)
+            {
+                const auto self = static_cast<WaylandWindowManager*>(data);
+                const auto it = std::ranges::find_if(self->_outputs, [name](const std::unique_ptr<OutputInfo>& output)
+                {
+                    return output->name == name;
+                });
+                if (it == self->_outputs.end()) return;
+                // An unplugged output never sends leave for the surfaces on it
+                const auto removed = it->get();
+                self->_windows.ForEach([self, removed](WindowInfo& info)
+                {
+                    if (std::erase(info.outputs, removed) != 0)
+                    {
+                        self->UpdateOutputScale(&info);
+                    }
+                });
+                releaseOutput(removed->output);
+                self->_outputs.erase(it);
             },
         };
 
@@ -571,29 +887,38 @@ namespace rwin
                     libdecor_frame_commit(frame, state, configuration);
                     libdecor_state_free(state);
 
+                    auto windowState = LIBDECOR_WINDOW_STATE_NONE;
+                    libdecor_configuration_get_window_state(configuration, &windowState);
+                    info->configured = true;
+                    info->windowManager->SetState(info, toWindowState(windowState));
+
                     if (newExtent != info->size)
                     {
                         info->size = newExtent;
+                        info->windowManager->ApplyScale(info);
+                        if (!info->Accepts(WindowEventType::Resize)) return;
                         WindowEvent ev{};
                         new(&ev.resize) ResizeEvent{
                             .type = WindowEventType::Resize,
                             .windowId = info->windowId,
+                            .timestamp = monotonicTime(),
                             .size = info->size,
                         };
-                        info->windowManager->_pendingEvents.push_back(ev);
+                        info->windowManager->PushEvent(ev);
                     }
                 }
             },
             .close = [](struct libdecor_frame* frame, void* user_data)
             {
-                if (const auto info = static_cast<WindowInfo*>(user_data))
+                if (const auto info = static_cast<WindowInfo*>(user_data); info && info->Accepts(WindowEventType::Close))
                 {
                     WindowEvent ev{};
                     new(&ev.close) CloseEvent{
                         .type = WindowEventType::Close,
                         .windowId = info->windowId,
+                        .timestamp = monotonicTime(),
                     };
-                    info->windowManager->_pendingEvents.push_back(ev);
+                    info->windowManager->PushEvent(ev);
                 }
             },
             .commit = [](struct libdecor_frame* frame, void* user_data)
@@ -606,46 +931,259 @@ namespace rwin
         };
 
 
-        _decorInterface = {
-            .error = [](struct libdecor* context,
-                        enum libdecor_error error,
-                        const char* message)
+        _frameCallbackListener = {
+            .done = [](void* data,
+                       struct wl_callback* callback,
+                       uint32_t time)
             {
-                std::cerr << "Caught libdecor error (" << error << "): " << message << std::endl;
-                exit(EXIT_FAILURE);
+                wl_callback_destroy(callback);
+                if (const auto info = static_cast<WindowInfo*>(data))
+                {
+                    info->frameCallback = nullptr;
+                    if (!info->Accepts(WindowEventType::FrameReady)) return;
+                    WindowEvent ev{};
+                    new(&ev.frameReady) FrameReadyEvent{
+                        .type = WindowEventType::FrameReady,
+                        .windowId = info->windowId,
+                        .timestamp = monotonicTime(),
+                    };
+                    info->windowManager->PushEvent(ev);
+                }
             }
         };
 
-        _displayListener = {
-            .error = [](void *data,
-                        struct wl_display *wl_display,
-                        void *object_id,
-                        uint32_t code,
-                        const char *message) {
-                std::cerr << "Display listener error: " << message << std::endl;
-            }
+        _surfaceListener = {
+            .enter = [](void* data,
+                        struct wl_surface* surface,
+                        struct wl_output* output)
+            {
+                // The output may already be destroyed on our side, the compositor then sends null
+                const auto info = static_cast<WindowInfo*>(data);
+                if (info == nullptr || output == nullptr) return;
+                if (const auto outputInfo = static_cast<OutputInfo*>(wl_output_get_user_data(output)))
+                {
+                    info->outputs.push_back(outputInfo);
+                    info->windowManager->UpdateOutputScale(info);
+                }
+            },
+            .leave = [](void* data,
+                        struct wl_surface* surface,
+                        struct wl_output* output)
+            {
+                const auto info = static_cast<WindowInfo*>(data);
+                if (info == nullptr || output == nullptr) return;
+                std::erase(info->outputs, static_cast<OutputInfo*>(wl_output_get_user_data(output)));
+                info->windowManager->UpdateOutputScale(info);
+            },
+            .preferred_buffer_scale = [](void* data,
+                                         struct wl_surface* surface,
+                                         int32_t factor)
+            {
+                // Integer only, fractional scale reports the same preference more precisely when both exist
+                if (const auto info = static_cast<WindowInfo*>(data); info && info->fractionalScale == nullptr)
+                {
+                    info->preferredScale = true;
+                    info->windowManager->SetScale(info, static_cast<float>(factor));
+                }
+            },
+            .preferred_buffer_transform = [](void* data,
+                                             struct wl_surface* surface,
+                                             uint32_t transform)
+            {
+            },
         };
 
-        _xkbContext = xkb_context_new(static_cast<xkb_context_flags>(0));
-        _display = wl_display_connect(nullptr);
-        //wl_display_add_listener(_display,&_displayListener,nullptr); // errors out with display already has a listener ?
-        _registry = wl_display_get_registry(_display);
-        wl_registry_add_listener(_registry, &_registryListener, this);
-        wl_display_roundtrip(_display);
-        _decorContext = libdecor_new(_display, &_decorInterface);
-    }
-
-    WaylandWindowManager::~WaylandWindowManager()
-    {
-        if (_keyboard) wl_keyboard_destroy(_keyboard);
-        if (_pointer) wl_pointer_destroy(_pointer);
-        if (_seat) wl_seat_destroy(_seat);
-        if (_decorContext) libdecor_unref(_decorContext);
-        if (_compositor) wl_compositor_destroy(_compositor);
-        if (_registry) wl_registry_destroy(_registry);
-        if (_display) wl_display_disconnect(_display);
-        _keyboards.clear();
-        if (_xkbContext) xkb_context_unref(_xkbContext);
+        _outputListener = {
+            .geometry = [](void* data,
+                           struct wl_output* output,
+                           int32_t x,
+                           int32_t y,
+                           int32_t physical_width,
+                           int32_t physical_height,
+                           int32_t subpixel,
+                           const char* make,
+                           const char* model,
+                           int32_t transform)
+            {
+            },
+            .mode = [](void* data,
+                       struct wl_output* output,
+                       uint32_t flags,
+                       int32_t width,
+                       int32_t height,
+                       int32_t refresh)
+            {
+            },
+            .done = [](void* data,
+                       struct wl_output* output)
+            {
+                // A new scale takes effect once the output's properties are done changing
+                if (const auto outputInfo = static_cast<OutputInfo*>(data))
+                {
+                    const auto self = outputInfo->windowManager;
+                    self->_windows.ForEach([self](WindowInfo& info)
+                    {
+                        self->UpdateOutputScale(&info);
+                    });
+                }
+            },
+            .scale = [](void* data,
+                        struct wl_output* output,
+                        int32_t factor)
+            {
+                if (const auto outputInfo = static_cast<OutputInfo*>(data))
+                {
+                    outputInfo->scale = std::max(factor, 1);
+                }
+            },
+            .name = [](void* data,
+                       struct wl_output* output,
+                       const char* name)
+            {
+            },
+            .description = [](void* data,
+                              struct wl_output* output,
+                              const char* description)
+            {
+            },
+        };
+
+        _fractionalScaleListener = {
+            .preferred_scale = [](void* data,
+                                  struct wp_fractional_scale_v1* fractional_scale,
+                                  uint32_t scale)
+            {
+                if (const auto info = static_cast<WindowInfo*>(data))
+                {
+                    // Sent in 120ths
+                    info->preferredScale = true;
+                    info->windowManager->SetScale(info, static_cast<float>(scale) / 120.0f);
+                }
+            }
+        };
+
+        _presentationListener = {
+            .clock_id = [](void* data,
+                           struct wp_presentation* presentation,
+                           uint32_t clk_id)
+            {
+                if (const auto self = static_cast<WaylandWindowManager*>(data))
+                {
+                    self->_presentationClock = static_cast<clockid_t>(clk_id);
+                }
+            }
+        };
+
+        _presentFeedbackListener = {
+            .sync_output = [](void* data,
+                              struct wp_presentation_feedback* feedback,
+                              struct wl_output* output)
+            {
+            },
+            .presented = [](void* data,
+                            struct wp_presentation_feedback* feedback,
+                            uint32_t tv_sec_hi,
+                            uint32_t tv_sec_lo,
+                            uint32_t tv_nsec,
+                            uint32_t refresh,
+                            uint32_t seq_hi,
+                            uint32_t seq_lo,
+                            uint32_t flags)
+            {
+                if (const auto info = static_cast<WindowInfo*>(data))
+                {
+                    const auto seconds = (static_cast<std::uint64_t>(tv_sec_hi) << 32) | tv_sec_lo;
+                    info->windowManager->PushPresented(info, feedback, PresentedEvent{
+                                                           .timestamp = toMonotonicTime(
+                                                               info->windowManager->_presentationClock,
+                                                               seconds * 1000000000 + tv_nsec),
+                                                           .refresh = refresh,
+                                                           .msc = (static_cast<std::uint64_t>(seq_hi) << 32) | seq_lo,
+                                                           .flags = static_cast<PresentFlags>(flags),
+                                                       });
+                }
+            },
+            .discarded = [](void* data,
+                            struct wp_presentation_feedback* feedback)
+            {
+                if (const auto info = static_cast<WindowInfo*>(data))
+                {
+                    info->windowManager->PushPresented(info, feedback, PresentedEvent{
+                                                           .flags = PresentFlags::Discarded,
+                                                       });
+                }
+            }
+        };
+
+        _decorInterface = {
+            .error = [](struct libdecor* context,
+                        enum libdecor_error error,
+                        const char* message)
+            {
+                std::cerr << "Caught libdecor error (" << error << "): " << message << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        };
+
+        _displayListener = {
+            .error = [](void *data,
+                        struct wl_display *wl_display,
+                        void *object_id,
+                        uint32_t code,
+                        const char *message) {
+                std::cerr << "Display listener error: " << message << std::endl;
+            }
+        };
+
+        _xkbContext = xkb_context_new(static_cast<xkb_context_flags>(0));
+        _display = wl_display_connect(nullptr);
+        //wl_display_add_listener(_display,&_displayListener,nullptr); // errors out with display already has a listener ?
+        _repeatFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+        _eventFd = epoll_create1(EPOLL_CLOEXEC);
+        watchFd(_eventFd, wl_display_get_fd(_display));
+        watchFd(_eventFd, _repeatFd);
+        _registry = wl_display_get_registry(_display);
+        wl_registry_add_listener(_registry, &_registryListener, this);
+        wl_display_roundtrip(_display);
+        // Without an input method running the compositor never enters this object and typing arrives as keys
+        if (_textInputManager && _seat)
+        {
+            _textInput = zwp_text_input_manager_v3_get_text_input(_textInputManager, _seat);
+            zwp_text_input_v3_add_listener(_textInput, &_textInputListener, this);
+        }
+        _decorContext = libdecor_new(_display, &_decorInterface);
+    }
+
+    WaylandWindowManager::~WaylandWindowManager()
+    {
+        StopInputThread();
+        if (_keyboardTimestamps) zwp_input_timestamps_v1_destroy(_keyboardTimestamps);
+        if (_pointerTimestamps) zwp_input_timestamps_v1_destroy(_pointerTimestamps);
+        if (_timestampsManager) zwp_input_timestamps_manager_v1_destroy(_timestampsManager);
+        if (_relativePointer) zwp_relative_pointer_v1_destroy(_relativePointer);
+        if (_relativePointerManager) zwp_relative_pointer_manager_v1_destroy(_relativePointerManager);
+        if (_pointerConstraints) zwp_pointer_constraints_v1_destroy(_pointerConstraints);
+        if (_presentation) wp_presentation_destroy(_presentation);
+        if (_viewporter) wp_viewporter_destroy(_viewporter);
+        if (_fractionalScaleManager) wp_fractional_scale_manager_v1_destroy(_fractionalScaleManager);
+        for (const auto& output : _outputs)
+        {
+            releaseOutput(output->output);
+        }
+        _outputs.clear();
+        if (_textInput) zwp_text_input_v3_destroy(_textInput);
+        if (_textInputManager) zwp_text_input_manager_v3_destroy(_textInputManager);
+        if (_keyboard) wl_keyboard_destroy(_keyboard);
+        if (_pointer) wl_pointer_destroy(_pointer);
+        if (_seat) wl_seat_destroy(_seat);
+        if (_decorContext) libdecor_unref(_decorContext);
+        if (_compositor) wl_compositor_destroy(_compositor);
+        if (_registry) wl_registry_destroy(_registry);
+        if (_display) wl_display_disconnect(_display);
+        if (_eventFd >= 0) close(_eventFd);
+        if (_repeatFd >= 0) close(_repeatFd);
+        _keyboardInfo.reset();
+        if (_xkbContext) xkb_context_unref(_xkbContext);
     }
 
     vk::SurfaceKHR WaylandWindowManager::CreateSurface(const std::uint64_t& id, const vk::Instance& instance)
@@ -668,60 +1206,144 @@ namespace rwin
 
     std::uint64_t WaylandWindowManager::GetEvents(const std::span<WindowEvent>& events)
     {
-        int count = 0;
-        for (auto& event : events)
+        DrainInputEvents();
+        return PopOrdered(_eventQueues, events);
+    }
+
+    std::span<const WindowEvent> WaylandWindowManager::PeekEvents()
+    {
+        DrainInputEvents();
+        std::size_t count = 0;
+        if (const auto queue = FindOldestRun(_eventQueues, count))
         {
-            if (_pendingEvents.empty())
-            {
-                break;
-            }
+            return queue->Peek().first(count);
+        }
+        return {};
+    }
+
+    void WaylandWindowManager::ConsumeEvents(const std::uint64_t& count)
+    {
+        // Nothing older can be queued between a peek and this call so the run found here is the one that was peeked
+        std::size_t run = 0;
+        if (const auto queue = FindOldestRun(_eventQueues, run))
+        {
+            queue->Consume(std::min<std::size_t>(count, run));
+        }
+    }
+
+    std::uint64_t WaylandWindowManager::GetEvents(const std::uint64_t& id, const std::span<WindowEvent>& events)
+    {
+        DrainInputEvents();
+        if (const auto info = GetWindowInfo(id))
+        {
+            return info->events.Pop(events);
+        }
+        return 0;
+    }
+
+    std::span<const WindowEvent> WaylandWindowManager::PeekEvents(const std::uint64_t& id)
+    {
+        DrainInputEvents();
+        if (const auto info = GetWindowInfo(id))
+        {
+            return info->events.Peek();
+        }
+        return {};
+    }
 
-            event = _pendingEvents.front();
-            _pendingEvents.pop_front();
-            count++;
+    void WaylandWindowManager::ConsumeEvents(const std::uint64_t& id, const std::uint64_t& count)
+    {
+        if (const auto info = GetWindowInfo(id))
+        {
+            info->events.Consume(count);
         }
-        return count;
     }
 
     std::uint64_t WaylandWindowManager::Create(const std::string_view& title, const Extent2D& size,
                                                const Flags<WindowFlags>& flags)
     {
-        const auto windowId = _idFactory.New();
-        auto windowInfo = std::make_shared<WindowInfo>();
+        std::unique_lock guard{_windowsMutex};
+        const auto windowId = _windows.Emplace();
+        const auto windowInfo = _windows.Get(windowId);
         windowInfo->windowId = windowId;
         const auto surface = wl_compositor_create_surface(_compositor);
-        const auto frame = libdecor_decorate(_decorContext, surface, &_frameInterface, windowInfo.get());
-        _windows.insert_or_assign(windowId, windowInfo);
+        const auto frame = libdecor_decorate(_decorContext, surface, &_frameInterface, windowInfo);
         windowInfo->windowManager = this;
         windowInfo->surface = surface;
-        _surfaceToWindows.insert_or_assign(surface, windowInfo);
+        wl_surface_add_listener(surface, &_surfaceListener, windowInfo);
+        wl_proxy_set_tag(reinterpret_cast<wl_proxy*>(surface), &SURFACE_TAG);
+        // With a viewport the buffer can be any size, so a swapchain at size * scale pixels needs no buffer scale.
+        // A fractional scale cannot be presented without one, the surface then only hears integer preferences
+        if (_viewporter)
+        {
+            windowInfo->viewport = wp_viewporter_get_viewport(_viewporter, surface);
+        }
+        if (_viewporter && _fractionalScaleManager)
+        {
+            windowInfo->fractionalScale = wp_fractional_scale_manager_v1_get_fractional_scale(_fractionalScaleManager, surface);
+            wp_fractional_scale_v1_add_listener(windowInfo->fractionalScale, &_fractionalScaleListener, windowInfo);
+        }
         windowInfo->flags = flags;
         windowInfo->size = size;
         windowInfo->frame = frame;
+        windowInfo->events.SetMotionCoalescing(_motionCoalescing);
+        _eventQueues.push_back(&windowInfo->events);
+        ApplyScale(windowInfo);
 
         libdecor_frame_set_title(frame, title.data());
-        libdecor_frame_set_app_id(frame, "rin_app");
+        libdecor_frame_set_app_id(frame, APP_ID);
+        // Always mapped like before Hide existed, callers that want a hidden window call Hide after Create
+        windowInfo->mapped = true;
         libdecor_frame_map(frame);
-        PumpEvents();
+        guard.unlock();
+        Sync();
         return windowId;
     }
 
     void WaylandWindowManager::Destroy(const std::uint64_t& id)
     {
-        if (id == _cursorFocusedHandle)
-        {
-            _cursorFocusedHandle = std::numeric_limits<std::uint64_t>::max();
-        }
-
-        if (id == _keyboardFocusedHandle)
-        {
-            _keyboardFocusedHandle = std::numeric_limits<std::uint64_t>::max();
-        }
+        std::lock_guard guard{_windowsMutex};
         if (const auto info = GetWindowInfo(id))
         {
+            if (_cursorFocus == info)
+            {
+                _cursorFocus = nullptr;
+            }
+
+            if (_keyboardFocus == info)
+            {
+                _keyboardFocus = nullptr;
+                StopRepeat();
+            }
+
+            if (_textInputFocus == info)
+            {
+                _textInputFocus = nullptr;
+                _preedit.clear();
+            }
+
+            ReleasePointer(info);
+            if (info->frameCallback)
+            {
+                wl_callback_destroy(info->frameCallback);
+            }
+            for (const auto feedback : info->presentFeedback)
+            {
+                wp_presentation_feedback_destroy(feedback);
+            }
+            if (info->fractionalScale)
+            {
+                wp_fractional_scale_v1_destroy(info->fractionalScale);
+            }
+            if (info->viewport)
+            {
+                wp_viewport_destroy(info->viewport);
+            }
             libdecor_frame_unref(info->frame);
             wl_surface_destroy(info->surface);
-            _windows.erase(id);
+            std::erase(_eventQueues, &info->events);
+            _windows.Erase(id);
+            UpdateRelativePointer();
         }
     }
 
@@ -741,23 +1363,45 @@ namespace rwin
 
     Vector2 WaylandWindowManager::GetCursorPosition(const std::uint64_t& id)
     {
+        std::lock_guard guard{_windowsMutex};
         if (const auto info = GetWindowInfo(id))
         {
-            return info->cursorPosition;
+            return info->input.cursorPosition;
         }
         return {};
     }
 
     void WaylandWindowManager::Show(const std::uint64_t& id)
     {
-
+        if (const auto info = GetWindowInfo(id); info && !info->mapped)
+        {
+            info->mapped = true;
+            // Unmapping discards the title and app id, libdecor only sends them when they change
+            if (const auto toplevel = libdecor_frame_get_xdg_toplevel(info->frame))
+            {
+                xdg_toplevel_set_title(toplevel, libdecor_frame_get_title(info->frame));
+                xdg_toplevel_set_app_id(toplevel, APP_ID);
+            }
+            // Commits without a buffer, the window turns visible on the configure that answers it
+            libdecor_frame_map(info->frame);
+        }
     }
 
     void WaylandWindowManager::Hide(const std::uint64_t& id)
     {
-        if (const auto info = GetWindowInfo(id))
+        if (const auto info = GetWindowInfo(id); info && info->mapped)
         {
-
+            info->mapped = false;
+            info->configured = false;
+            // Callbacks of an unmapped surface never fire, RequestFrame asks again once it is shown
+            if (info->frameCallback)
+            {
+                wl_callback_destroy(info->frameCallback);
+                info->frameCallback = nullptr;
+            }
+            wl_surface_attach(info->surface, nullptr, 0, 0);
+            wl_surface_commit(info->surface);
+            UpdateVisibility(info);
         }
     }
 
@@ -779,6 +1423,10 @@ namespace rwin
 
     float WaylandWindowManager::GetDpi(const std::uint64_t& id)
     {
+        if (const auto info = GetWindowInfo(id))
+        {
+            return GetDefaultDpi() * info->scale;
+        }
         return GetDefaultDpi();
     }
 
@@ -788,48 +1436,887 @@ namespace rwin
     }
 
     void WaylandWindowManager::PumpEvents()
+    {
+        ReadEvents(std::chrono::nanoseconds::zero());
+    }
+
+    void WaylandWindowManager::WaitEvents(const std::chrono::nanoseconds& timeout)
+    {
+        ReadEvents(std::max(timeout, std::chrono::nanoseconds::zero()));
+    }
+
+    void WaylandWindowManager::Sync()
     {
         wl_display_roundtrip(_display);
     }
 
-    void WaylandWindowManager::GetRequiredExtensions(std::vector<const char*>& extensions)
+    int WaylandWindowManager::GetEventFd()
     {
-        extensions.emplace_back(VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME);
-        extensions.emplace_back(vk::KHRSurfaceExtensionName);
+        return _eventFd;
     }
 
-    void WaylandWindowManager::SetHitTestCallback(const std::uint64_t& id,
-                                                  const std::function<HitTestResult(const Vector2&)>& callback)
+    bool WaylandWindowManager::PrepareRead()
     {
+        const auto canBlock = BeginRead();
+        // Anything the compositor has to answer before it wakes the caller must be sent before they sleep
+        wl_display_flush(_display);
+        return canBlock;
     }
 
-    void WaylandWindowManager::ClearHitTestCallback(const std::uint64_t& id)
+    void WaylandWindowManager::Dispatch(const bool& readable)
     {
+        auto displayReadable = false;
+        auto repeatDue = false;
+        if (readable)
+        {
+            // Level triggered, so a zero timeout wait reports exactly which descriptors woke the caller
+            epoll_event ready[3]{};
+            const auto count = epoll_wait(_eventFd, ready, 3, 0);
+            for (auto i = 0; i < count; i++)
+            {
+                const auto fd = ready[i].data.fd;
+                if (fd == _repeatFd)
+                {
+                    repeatDue = true;
+                }
+                else if (fd == _inputReadyFd)
+                {
+                    std::uint64_t produced{};
+                    read(_inputReadyFd, &produced, sizeof(produced));
+                }
+                else
+                {
+                    displayReadable = true;
+                }
+            }
+        }
+
+        if (displayReadable)
+        {
+            wl_display_read_events(_display);
+        }
+        else
+        {
+            wl_display_cancel_read(_display);
+        }
+
+        wl_display_dispatch_pending(_display);
+        if (repeatDue)
+        {
+            HandleRepeatTimer();
+        }
+        // Requests made since the last pump and by the listeners above go out in a single write
+        wl_display_flush(_display);
+        DrainInputEvents();
+        _dispatchedSequence = _eventSequence;
+        PublishScroll();
     }
 
-    void WaylandWindowManager::SetDropCallbacks(const std::uint64_t& id, const DropCallbacks& callbacks)
+    bool WaylandWindowManager::BeginRead()
+    {
+        while (wl_display_prepare_read(_display) != 0)
+        {
+            wl_display_dispatch_pending(_display);
+        }
+
+        DrainInputEvents();
+        for (const auto queue : _eventQueues)
+        {
+            queue->ReleaseHistory();
+        }
+        ReleaseText();
+        // Events left unread in some queue must not keep waking the caller, only ones queued since the last dispatch do
+        return _eventSequence == _dispatchedSequence;
+    }
+
+    void WaylandWindowManager::ReadEvents(const std::chrono::nanoseconds& timeout)
     {
+        // Do not sleep when events arrived since the caller last dispatched, those are what it is waiting for
+        const auto wait = BeginRead() ? timeout : std::chrono::nanoseconds::zero();
+        if (wait > std::chrono::nanoseconds::zero())
+        {
+            // Anything the compositor has to answer before it wakes us must be sent before we sleep
+            wl_display_flush(_display);
+        }
+        const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(wait);
+        const timespec waitTime{
+            .tv_sec = static_cast<time_t>(seconds.count()),
+            .tv_nsec = static_cast<long>((wait - seconds).count())
+        };
+
+        pollfd fd{
+            .fd = _eventFd,
+            .events = POLLIN,
+            .revents = 0
+        };
+        const auto forever = wait == std::chrono::nanoseconds::max();
+        Dispatch(ppoll(&fd, 1, forever ? nullptr : &waitTime, nullptr) > 0);
     }
 
-    void WaylandWindowManager::ClearDropCallbacks(const std::uint64_t& id)
+    void WaylandWindowManager::StartInputThread()
     {
+        if (_inputThread.joinable())
+        {
+            return;
+        }
+
+        _inputQueue = wl_display_create_queue(_display);
+        _inputWakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        _inputReadyFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        MoveInputToQueue(_inputQueue);
+        // The keyboard is dispatched on the input thread from now on so its repeat timer goes with it
+        epoll_ctl(_eventFd, EPOLL_CTL_DEL, _repeatFd, nullptr);
+        watchFd(_eventFd, _inputReadyFd);
+        _inputThreadRunning = true;
+        _inputThread = std::thread([this]
+        {
+            ON_INPUT_THREAD = true;
+            RunInputThread();
+        });
     }
 
-    WindowInfo* WaylandWindowManager::GetWindowInfo(const std::uint64_t& id)
+    void WaylandWindowManager::StopInputThread()
     {
-        if (_windows.contains(id))
+        if (!_inputThread.joinable())
         {
-            return _windows[id].get();
+            return;
         }
 
-        return nullptr;
+        _inputThreadRunning = false;
+        constexpr std::uint64_t wake = 1;
+        write(_inputWakeFd, &wake, sizeof(wake));
+        _inputThread.join();
+
+        // Keep the order the thread produced events in, then handle whatever it had not dispatched yet here
+        DrainInputEvents();
+        for (const auto& event : _inputOverflow)
+        {
+            QueueEvent(event);
+        }
+        _inputOverflow.clear();
+        _windows.ForEach([](WindowInfo& info)
+        {
+            info.textInFlight = 0;
+        });
+        MoveInputToQueue(nullptr);
+        wl_display_dispatch_queue_pending(_display, _inputQueue);
+        wl_event_queue_destroy(_inputQueue);
+        _inputQueue = nullptr;
+        epoll_ctl(_eventFd, EPOLL_CTL_DEL, _inputReadyFd, nullptr);
+        watchFd(_eventFd, _repeatFd);
+        close(_inputWakeFd);
+        close(_inputReadyFd);
+        _inputWakeFd = -1;
+        _inputReadyFd = -1;
+    }
+
+    void WaylandWindowManager::PushEvent(const WindowEvent& event)
+    {
+        if (ON_INPUT_THREAD)
+        {
+            FlushInputOverflow();
+            if (!_inputOverflow.empty() || !_inputEvents.TryPush(event))
+            {
+                _inputOverflow.push_back(event);
+            }
+            _inputProduced = true;
+            if (carriesText(event))
+            {
+                if (const auto info = GetWindowInfo(event.info.windowId))
+                {
+                    info->textInFlight++;
+                }
+            }
+            return;
+        }
+
+        QueueEvent(event);
+    }
+
+    void WaylandWindowManager::PushText(WindowInfo* info, const std::string_view& text, const std::uint64_t& timestamp)
+    {
+        if (text.empty() || !info->Accepts(WindowEventType::Text)) return;
+        const auto stored = info->events.StoreText(text);
+        WindowEvent ev{};
+        new(&ev.text) TextEvent{
+            .type = WindowEventType::Text,
+            .windowId = info->windowId,
+            .timestamp = timestamp,
+            .text = stored.data(),
+            .length = static_cast<std::uint32_t>(stored.size()),
+        };
+        PushEvent(ev);
+    }
+
+    void WaylandWindowManager::PushComposition(WindowInfo* info, const std::string_view& text,
+                                               const std::int32_t& cursorBegin, const std::int32_t& cursorEnd)
+    {
+        if (!info->Accepts(WindowEventType::Composition)) return;
+        const auto stored = info->events.StoreText(text);
+        WindowEvent ev{};
+        new(&ev.composition) CompositionEvent{
+            .type = WindowEventType::Composition,
+            .windowId = info->windowId,
+            .timestamp = monotonicTime(),
+            .text = stored.data(),
+            .length = static_cast<std::uint32_t>(stored.size()),
+            .cursorBegin = cursorBegin,
+            .cursorEnd = cursorEnd,
+        };
+        PushEvent(ev);
+    }
+
+    void WaylandWindowManager::QueueEvent(WindowEvent event)
+    {
+        // Events for windows destroyed after the event was produced are dropped here
+        if (const auto info = GetWindowInfo(event.info.windowId))
+        {
+            event.info.sequence = _eventSequence++;
+            info->events.Push(event);
+        }
+    }
+
+    void WaylandWindowManager::StagePointerEvent(const WindowEvent& event)
+    {
+        _pointerEvents.push_back(event);
+        // Seats older than version 5 send no frame event, each event is a frame of its own
+        if (!_pointerFrames)
+        {
+            FlushPointerFrame();
+        }
+    }
+
+    void WaylandWindowManager::StageScroll(const std::uint64_t& timestamp)
+    {
+        _pendingScroll.timestamp = timestamp;
+        if (!_pendingScroll.active)
+        {
+            _pendingScroll.active = true;
+            if (const auto info = _cursorFocus; info && info->Accepts(WindowEventType::Scroll))
+            {
+                _pendingScroll.slot = _pointerEvents.size();
+                WindowEvent ev{};
+                new(&ev.scroll) ScrollEvent{
+                    .type = WindowEventType::Scroll,
+                    .windowId = info->windowId,
+                };
+                _pointerEvents.push_back(ev);
+            }
+        }
+
+        if (!_pointerFrames)
+        {
+            FlushPointerFrame();
+        }
+    }
+
+    void WaylandWindowManager::FlushPointerFrame()
+    {
+        // The scroll is written last since axis values keep arriving until the frame ends
+        if (const auto scroll = std::exchange(_pendingScroll, {}); scroll.slot)
+        {
+            auto& staged = _pointerEvents[*scroll.slot].scroll;
+            staged.timestamp = scroll.timestamp;
+            staged.position = _cursorFocus ? _cursorFocus->input.cursorPosition : Vector2{};
+            staged.delta = scroll.delta;
+            staged.detents = scroll.detents;
+            staged.source = scroll.source;
+            staged.stopped = static_cast<ScrollAxis>(scroll.stopped);
+        }
+
+        if (_pointerEvents.empty())
+        {
+            return;
+        }
+
+        const auto frame = _pointerFrame++;
+        // Relative motion carries no usable time, it shares the latest wl_pointer time of its frame
+        std::uint64_t frameTime = 0;
+        for (const auto& event : _pointerEvents)
+        {
+            if (event.info.type != WindowEventType::RawMotion)
+            {
+                frameTime = std::max(frameTime, event.info.timestamp);
+            }
+        }
+
+        for (auto& event : _pointerEvents)
+        {
+            switch (event.info.type)
+            {
+            case WindowEventType::CursorMove:
+                event.cursorMove.frame = frame;
+                break;
+            case WindowEventType::CursorButton:
+                event.cursorButton.frame = frame;
+                break;
+            case WindowEventType::Scroll:
+                event.scroll.frame = frame;
+                break;
+            case WindowEventType::RawMotion:
+                event.rawMotion.frame = frame;
+                // A locked pointer only reports relative motion, those frames are stamped when they arrive
+                event.rawMotion.timestamp = frameTime != 0 ? frameTime : monotonicTime();
+                break;
+            default:
+                break;
+            }
+            PushEvent(event);
+        }
+        _pointerEvents.clear();
+    }
+
+    void WaylandWindowManager::DrainInputEvents()
+    {
+        WindowEvent event{};
+        while (_inputEvents.TryPop(event))
+        {
+            if (carriesText(event))
+            {
+                if (const auto info = GetWindowInfo(event.info.windowId))
+                {
+                    info->textInFlight--;
+                }
+            }
+            QueueEvent(event);
+        }
+    }
+
+    void WaylandWindowManager::PublishScroll()
+    {
+        // The input thread adds scroll under the lock
+        std::lock_guard guard{_windowsMutex};
+        _windows.ForEach([](WindowInfo& info)
+        {
+            info.scroll.Publish(info.input);
+        });
+    }
+
+    void WaylandWindowManager::ReleaseText()
+    {
+        // The input thread stores text while dispatching under the lock, what it stored but has not handed over yet must survive
+        std::lock_guard guard{_windowsMutex};
+        _windows.ForEach([](WindowInfo& info)
+        {
+            if (info.textInFlight == 0)
+            {
+                info.events.ReleaseText();
+            }
+        });
+    }
+
+    void WaylandWindowManager::UpdateTextInput(WindowInfo* info)
+    {
+        // Windows that take no text keep the input method out of the way
+        const auto enable = info != nullptr &&
+            (info->eventMask.Has(WindowEventType::Text) || info->eventMask.Has(WindowEventType::Composition));
+        if (_textInput == nullptr || enable == _textInputEnabled)
+        {
+            return;
+        }
+
+        if (enable)
+        {
+            zwp_text_input_v3_enable(_textInput);
+            zwp_text_input_v3_set_content_type(_textInput, ZWP_TEXT_INPUT_V3_CONTENT_HINT_NONE,
+                                               ZWP_TEXT_INPUT_V3_CONTENT_PURPOSE_NORMAL);
+        }
+        else
+        {
+            zwp_text_input_v3_disable(_textInput);
+        }
+        zwp_text_input_v3_commit(_textInput);
+        _textInputEnabled = enable;
+    }
+
+    void WaylandWindowManager::StartRepeat(const xkb_keycode_t& keyCode, const InputKey& key, const std::uint64_t& pressed)
+    {
+        if (_repeatRate == 0)
+        {
+            return;
+        }
+
+        _repeatKeyCode = keyCode;
+        _repeatKey = key;
+        _repeatNext = pressed + static_cast<std::uint64_t>(_repeatDelay) * 1000000;
+        ArmRepeatTimer(_repeatNext);
+    }
+
+    void WaylandWindowManager::StopRepeat()
+    {
+        _repeatKeyCode = 0;
+        _repeatNext = 0;
+        ArmRepeatTimer(0);
+    }
+
+    void WaylandWindowManager::EmitRepeats(const std::uint64_t& time)
+    {
+        const auto info = _keyboardFocus;
+        const auto keyboard = _keyboardInfo.get();
+        if (_repeatNext == 0 || _repeatNext > time || info == nullptr || keyboard == nullptr)
+        {
+            return;
+        }
+
+        const auto interval = 1000000000 / static_cast<std::uint64_t>(_repeatRate);
+        const auto modifiers = static_cast<InputModifier>(getInputModifiers(keyboard->state));
+        char text[64];
+        const auto length = xkb_state_key_get_utf8(keyboard->state, _repeatKeyCode, text, sizeof(text));
+        const auto view = std::string_view{text, static_cast<std::size_t>(std::max(length, 0))};
+        // Each repeat carries the time it was due at rather than the time we woke up
+        for (; _repeatNext <= time; _repeatNext += interval)
+        {
+            if (info->Accepts(WindowEventType::Key))
+            {
+                WindowEvent ev{};
+                new(&ev.key) KeyEvent{
+                    .type = WindowEventType::Key,
+                    .windowId = info->windowId,
+                    .timestamp = _repeatNext,
+                    .key = _repeatKey,
+                    .state = InputState::Repeat,
+                    .modifier = modifiers
+                };
+                PushEvent(ev);
+            }
+
+            if (isPrintable(view))
+            {
+                PushText(info, view, _repeatNext);
+            }
+        }
+        ArmRepeatTimer(_repeatNext);
+    }
+
+    void WaylandWindowManager::HandleRepeatTimer()
+    {
+        std::uint64_t expirations{};
+        read(_repeatFd, &expirations, sizeof(expirations));
+        EmitRepeats(monotonicTime());
+    }
+
+    void WaylandWindowManager::ArmRepeatTimer(const std::uint64_t& deadline)
+    {
+        // An all zero value disarms the timer, a deadline already passed fires at once
+        const itimerspec spec{
+            .it_interval = {},
+            .it_value = {
+                .tv_sec = static_cast<time_t>(deadline / 1000000000),
+                .tv_nsec = static_cast<long>(deadline % 1000000000)
+            }
+        };
+        timerfd_settime(_repeatFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    }
+
+    void WaylandWindowManager::FlushInputOverflow()
+    {
+        auto flushed = _inputOverflow.begin();
+        while (flushed != _inputOverflow.end() && _inputEvents.TryPush(*flushed))
+        {
+            ++flushed;
+        }
+        _inputOverflow.erase(_inputOverflow.begin(), flushed);
+    }
+
+    void WaylandWindowManager::RunInputThread()
+    {
+        pollfd fds[3]{
+            {
+                .fd = wl_display_get_fd(_display),
+                .events = POLLIN,
+                .revents = 0
+            },
+            {
+                .fd = _inputWakeFd,
+                .events = POLLIN,
+                .revents = 0
+            },
+            {
+                .fd = _repeatFd,
+                .events = POLLIN,
+                .revents = 0
+            }
+        };
+
+        while (_inputThreadRunning)
+        {
+            {
+                std::lock_guard guard{_windowsMutex};
+                while (wl_display_prepare_read_queue(_display, _inputQueue) != 0)
+                {
+                    wl_display_dispatch_queue_pending(_display, _inputQueue);
+                }
+            }
+            wl_display_flush(_display);
+
+            // Retry soon when the consumer is behind instead of waiting for more input
+            const auto polled = poll(fds, 3, _inputOverflow.empty() ? -1 : 1) > 0;
+            const auto readable = polled && (fds[0].revents & POLLIN) != 0;
+            if (readable)
+            {
+                wl_display_read_events(_display);
+            }
+            else
+            {
+                wl_display_cancel_read(_display);
+            }
+
+            {
+                std::lock_guard guard{_windowsMutex};
+                wl_display_dispatch_queue_pending(_display, _inputQueue);
+                if (polled && (fds[2].revents & POLLIN) != 0)
+                {
+                    HandleRepeatTimer();
+                }
+            }
+            FlushInputOverflow();
+
+            if (_inputProduced)
+            {
+                _inputProduced = false;
+                constexpr std::uint64_t ready = 1;
+                write(_inputReadyFd, &ready, sizeof(ready));
+            }
+        }
+    }
+
+    void WaylandWindowManager::MoveInputToQueue(wl_event_queue* queue)
+    {
+        for (const auto proxy : {
+                 reinterpret_cast<wl_proxy*>(_seat),
+                 reinterpret_cast<wl_proxy*>(_keyboard),
+                 reinterpret_cast<wl_proxy*>(_pointer),
+                 reinterpret_cast<wl_proxy*>(_keyboardTimestamps),
+                 reinterpret_cast<wl_proxy*>(_pointerTimestamps),
+                 reinterpret_cast<wl_proxy*>(_relativePointer),
+                 reinterpret_cast<wl_proxy*>(_textInput)
+             })
+        {
+            if (proxy)
+            {
+                wl_proxy_set_queue(proxy, queue);
+            }
+        }
+    }
+
+    void WaylandWindowManager::SetMotionCoalescing(const MotionCoalescing& coalescing)
+    {
+        _motionCoalescing = coalescing;
+        for (const auto queue : _eventQueues)
+        {
+            queue->SetMotionCoalescing(coalescing);
+        }
+    }
+
+    void WaylandWindowManager::GetRequiredExtensions(std::vector<const char*>& extensions)
+    {
+        extensions.emplace_back(VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME);
+        extensions.emplace_back(vk::KHRSurfaceExtensionName);
+    }
+
+    void WaylandWindowManager::SetHitTestCallback(const std::uint64_t& id,
+                                                  const std::function<HitTestResult(const Vector2&)>& callback)
+    {
+    }
+
+    void WaylandWindowManager::ClearHitTestCallback(const std::uint64_t& id)
+    {
+    }
+
+    void WaylandWindowManager::SetDropCallbacks(const std::uint64_t& id, const DropCallbacks& callbacks)
+    {
+    }
+
+    void WaylandWindowManager::ClearDropCallbacks(const std::uint64_t& id)
+    {
+    }
+
+    void WaylandWindowManager::SetEventMask(const std::uint64_t& id, const Flags<WindowEventType>& mask)
+    {
+        std::lock_guard guard{_windowsMutex};
+        if (const auto info = GetWindowInfo(id))
+        {
+            info->eventMask = mask;
+            if (info == _textInputFocus)
+            {
+                UpdateTextInput(info);
+            }
+            UpdateRelativePointer();
+        }
+    }
+
+    std::uint64_t WaylandWindowManager::GetSuppressedEventCount(const std::uint64_t& id)
+    {
+        std::lock_guard guard{_windowsMutex};
+        if (const auto info = GetWindowInfo(id))
+        {
+            return info->suppressedEvents.load(std::memory_order_relaxed);
+        }
+        return 0;
+    }
+
+    InputSnapshot WaylandWindowManager::GetInputSnapshot(const std::uint64_t& id)
+    {
+        std::lock_guard guard{_windowsMutex};
+        if (const auto info = GetWindowInfo(id))
+        {
+            return info->input;
+        }
+        return {};
+    }
+
+    void WaylandWindowManager::SetUserData(const std::uint64_t& id, void* data)
+    {
+        if (const auto info = GetWindowInfo(id))
+        {
+            info->userData = data;
+        }
+    }
+
+    void* WaylandWindowManager::GetUserData(const std::uint64_t& id)
+    {
+        if (const auto info = GetWindowInfo(id))
+        {
+            return info->userData;
+        }
+        return nullptr;
+    }
+
+    std::span<const MotionSample> WaylandWindowManager::GetMotionHistory(const CursorMoveEvent& event)
+    {
+        if (const auto info = GetWindowInfo(event.windowId))
+        {
+            return info->events.GetMotionHistory(event);
+        }
+        return {};
+    }
+
+    void WaylandWindowManager::RequestFrame(const std::uint64_t& id)
+    {
+        // The request is surface state, the next commit, normally the one vkQueuePresentKHR makes, sends it
+        const auto info = GetWindowInfo(id);
+        // Nothing is drawn while hidden, the first frame after Show waits for VisibilityChanged instead
+        if (info == nullptr || !info->mapped)
+        {
+            return;
+        }
+
+        if (info->frameCallback == nullptr)
+        {
+            info->frameCallback = wl_surface_frame(info->surface);
+            wl_callback_add_listener(info->frameCallback, &_frameCallbackListener, info);
+        }
+
+        if (_presentation && info->eventMask.Has(WindowEventType::Presented))
+        {
+            const auto feedback = wp_presentation_feedback(_presentation, info->surface);
+            wp_presentation_feedback_add_listener(feedback, &_presentFeedbackListener, info);
+            info->presentFeedback.push_back(feedback);
+        }
+    }
+
+    WindowState WaylandWindowManager::GetState(const std::uint64_t& id)
+    {
+        if (const auto info = GetWindowInfo(id))
+        {
+            return info->state;
+        }
+        return WindowState::None;
+    }
+
+    void WaylandWindowManager::UpdateOutputScale(WindowInfo* info)
+    {
+        if (info->preferredScale) return;
+        std::int32_t scale = 1;
+        for (const auto output : info->outputs)
+        {
+            scale = std::max(scale, output->scale);
+        }
+        SetScale(info, static_cast<float>(scale));
+    }
+
+    void WaylandWindowManager::SetScale(WindowInfo* info, const float& scale)
+    {
+        if (scale <= 0.0f || scale == info->scale) return;
+        info->scale = scale;
+        ApplyScale(info);
+        if (!info->Accepts(WindowEventType::ScaleChanged)) return;
+        WindowEvent ev{};
+        new(&ev.scaleChanged) ScaleChangedEvent{
+            .type = WindowEventType::ScaleChanged,
+            .windowId = info->windowId,
+            .timestamp = monotonicTime(),
+            .scale = scale,
+            .dpi = GetDefaultDpi() * scale,
+        };
+        PushEvent(ev);
+    }
+
+    void WaylandWindowManager::ApplyScale(WindowInfo* info)
+    {
+        // Without a viewport the buffer scale stays 1, buffers keep matching GetClientSize and the scale is only
+        // reported through ScaleChanged
+        if (info->viewport)
+        {
+            wp_viewport_set_destination(info->viewport, static_cast<int32_t>(info->size.width),
+                                        static_cast<int32_t>(info->size.height));
+        }
+    }
+
+    void WaylandWindowManager::SetState(WindowInfo* info, const WindowState& state)
+    {
+        const auto previous = info->state;
+        if (state != previous)
+        {
+            info->state = state;
+            const auto gained = static_cast<std::uint32_t>(state) & ~static_cast<std::uint32_t>(previous);
+            // xdg_toplevel has no minimized state, Suspended is the closest the compositor reports
+            if ((gained & static_cast<std::uint32_t>(WindowState::Maximized)) != 0 &&
+                info->Accepts(WindowEventType::Maximize))
+            {
+                WindowEvent ev{};
+                new(&ev.maximize) MaximizeEvent{
+                    .type = WindowEventType::Maximize,
+                    .windowId = info->windowId,
+                    .timestamp = monotonicTime(),
+                };
+                PushEvent(ev);
+            }
+
+            if (info->Accepts(WindowEventType::StateChanged))
+            {
+                WindowEvent ev{};
+                new(&ev.stateChanged) StateChangedEvent{
+                    .type = WindowEventType::StateChanged,
+                    .windowId = info->windowId,
+                    .timestamp = monotonicTime(),
+                    .state = state,
+                    .previous = previous,
+                };
+                PushEvent(ev);
+            }
+        }
+        UpdateVisibility(info);
+    }
+
+    void WaylandWindowManager::UpdateVisibility(WindowInfo* info)
+    {
+        const auto visible = info->mapped && info->configured &&
+            (static_cast<std::uint32_t>(info->state) & static_cast<std::uint32_t>(WindowState::Suspended)) == 0;
+        if (visible == info->visible) return;
+        info->visible = visible;
+        if (!info->Accepts(WindowEventType::VisibilityChanged)) return;
+        WindowEvent ev{};
+        new(&ev.visibilityChanged) VisibilityChangedEvent{
+            .type = WindowEventType::VisibilityChanged,
+            .windowId = info->windowId,
+            .timestamp = monotonicTime(),
+            .visible = visible,
+        };
+        PushEvent(ev);
+    }
+
+    void WaylandWindowManager::PushPresented(WindowInfo* info, struct wp_presentation_feedback* feedback,
+                                             const PresentedEvent& presented)
+    {
+        // Feedback objects are done after their one event
+        std::erase(info->presentFeedback, feedback);
+        wp_presentation_feedback_destroy(feedback);
+        if (!info->Accepts(WindowEventType::Presented)) return;
+        WindowEvent ev{};
+        new(&ev.presented) PresentedEvent{presented};
+        ev.presented.type = WindowEventType::Presented;
+        ev.presented.windowId = info->windowId;
+        PushEvent(ev);
+    }
+
+    void WaylandWindowManager::LockPointer(const std::uint64_t& id)
+    {
+        std::lock_guard guard{_windowsMutex};
+        if (const auto info = GetWindowInfo(id); info && _pointerConstraints && _pointer)
+        {
+            ReleasePointer(info);
+            // Persistent so the lock comes back each time the pointer enters the window again
+            info->lockedPointer = zwp_pointer_constraints_v1_lock_pointer(
+                _pointerConstraints, info->surface, _pointer, nullptr, ZWP_POINTER_CONSTRAINTS_V1_LIFETIME_PERSISTENT);
+        }
+    }
+
+    void WaylandWindowManager::ConfinePointer(const std::uint64_t& id, const WindowRect& region)
+    {
+        std::lock_guard guard{_windowsMutex};
+        if (const auto info = GetWindowInfo(id); info && _pointerConstraints && _pointer)
+        {
+            ReleasePointer(info);
+            const auto confineRegion = wl_compositor_create_region(_compositor);
+            wl_region_add(confineRegion, region.position.x, region.position.y,
+                          static_cast<int32_t>(region.extent.width), static_cast<int32_t>(region.extent.height));
+            info->confinedPointer = zwp_pointer_constraints_v1_confine_pointer(
+                _pointerConstraints, info->surface, _pointer, confineRegion, ZWP_POINTER_CONSTRAINTS_V1_LIFETIME_PERSISTENT);
+            // The compositor copies the region when the request is sent
+            wl_region_destroy(confineRegion);
+        }
+    }
+
+    void WaylandWindowManager::ReleasePointer(const std::uint64_t& id)
+    {
+        std::lock_guard guard{_windowsMutex};
+        if (const auto info = GetWindowInfo(id))
+        {
+            ReleasePointer(info);
+        }
+    }
+
+    void WaylandWindowManager::UpdateRelativePointer()
+    {
+        auto wanted = false;
+        _windows.ForEach([&wanted](const WindowInfo& info)
+        {
+            wanted = wanted || info.eventMask.Has(WindowEventType::RawMotion);
+        });
+
+        if (wanted && _relativePointer == nullptr && _relativePointerManager && _pointer)
+        {
+            _relativePointer = zwp_relative_pointer_manager_v1_get_relative_pointer(_relativePointerManager, _pointer);
+            zwp_relative_pointer_v1_add_listener(_relativePointer, &_relativePointerListener, this);
+            // Follows the pointer onto the input thread's queue
+            if (_inputQueue)
+            {
+                wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(_relativePointer), _inputQueue);
+            }
+        }
+        else if (!wanted && _relativePointer)
+        {
+            zwp_relative_pointer_v1_destroy(_relativePointer);
+            _relativePointer = nullptr;
+        }
+    }
+
+    void WaylandWindowManager::ReleasePointer(WindowInfo* info)
+    {
+        if (info->lockedPointer)
+        {
+            zwp_locked_pointer_v1_destroy(info->lockedPointer);
+            info->lockedPointer = nullptr;
+        }
+
+        if (info->confinedPointer)
+        {
+            zwp_confined_pointer_v1_destroy(info->confinedPointer);
+            info->confinedPointer = nullptr;
+        }
+    }
+
+    WindowInfo* WaylandWindowManager::GetWindowInfo(const std::uint64_t& id)
+    {
+        return _windows.Get(id);
     }
 
     WindowInfo* WaylandWindowManager::GetWindowInfo(wl_surface* surface)
     {
-        if (_surfaceToWindows.contains(surface))
+        if (surface && wl_proxy_get_tag(reinterpret_cast<wl_proxy*>(surface)) == &SURFACE_TAG)
         {
-            return _surfaceToWindows[surface].get();
+            return static_cast<WindowInfo*>(wl_surface_get_user_data(surface));
         }
 
         return nullptr;
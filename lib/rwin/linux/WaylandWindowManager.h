@@ -5,15 +5,38 @@
 #include <span>
 #include <wayland-client-protocol.h>
 #include <libdecor.h>
-#include <unordered_set>
 #include <xdg-shell-client-protocol.h>
-#include "rwin/IdFactory.h"
+#include <input-timestamps-unstable-v1-client-protocol.h>
+#include <text-input-unstable-v3-client-protocol.h>
+#include <relative-pointer-unstable-v1-client-protocol.h>
+#include <pointer-constraints-unstable-v1-client-protocol.h>
+#include <presentation-time-client-protocol.h>
+#include <viewporter-client-protocol.h>
+#include <fractional-scale-v1-client-protocol.h>
+#include "rwin/EventQueue.h"
+#include "rwin/ScrollAccumulator.h"
+#include "rwin/SlotMap.h"
+#include "rwin/SpscQueue.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <xkbcommon/xkbcommon.h>
 
 namespace rwin
 {
     class WaylandWindowManager;
 
+    // A wl_output and the integer scale it announced, the fallback when the compositor sends no preferred scale
+    struct OutputInfo
+    {
+        WaylandWindowManager* windowManager = nullptr;
+        wl_output* output = nullptr;
+        std::uint32_t name = 0;
+        std::int32_t scale = 1;
+    };
+
     struct WindowInfo
     {
         std::uint64_t windowId{};
@@ -22,20 +45,71 @@ namespace rwin
         Flags<WindowFlags> flags{};
         Extent2D size{};
         libdecor_frame *frame = nullptr;
-        Vector2 cursorPosition{};
+        // At most one of these exists, set by LockPointer and ConfinePointer
+        zwp_locked_pointer_v1* lockedPointer = nullptr;
+        zwp_confined_pointer_v1* confinedPointer = nullptr;
+        // Pending wl_surface.frame callback, at most one per window
+        wl_callback* frameCallback = nullptr;
+        // One per commit still waiting for presented or discarded
+        std::vector<struct wp_presentation_feedback*> presentFeedback{};
+        // Maps the buffer onto the logical size so it can be any number of pixels, nullptr without wp_viewporter
+        wp_viewport* viewport = nullptr;
+        wp_fractional_scale_v1* fractionalScale = nullptr;
+        // Outputs the surface is on
+        std::vector<OutputInfo*> outputs{};
+        float scale = 1.0f;
+        // Set once the compositor sent a preferred scale, output scales are only a guess until then
+        bool preferredScale = false;
+        WindowState state = WindowState::None;
+        // Asked to be shown, cleared by Hide
+        bool mapped = false;
+        // The compositor configured the toplevel since it was last mapped, buffers may only be attached after that
+        bool configured = false;
+        bool visible = false;
+        InputSnapshot input{};
+        ScrollAccumulator scroll{};
         std::optional<DropCallbacks> dropCallbacks{};
         std::optional<std::function<HitTestResult(const Vector2&)>> hitTestFunction{};
+        Flags<WindowEventType> eventMask{DEFAULT_EVENT_MASK};
+        // Counted by main thread listeners without the windows mutex and by the input thread under it
+        std::atomic<std::uint64_t> suppressedEvents{0};
+        EventQueue events{};
+        // Text events the input thread produced for this window that the consumer has not queued yet
+        std::atomic<std::uint32_t> textInFlight{0};
+        void* userData = nullptr;
+
+        // Counts the event as suppressed when its type is masked out
+        bool Accepts(const WindowEventType& type)
+        {
+            if (eventMask.Has(type)) return true;
+            suppressedEvents.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
     };
 
     struct KeyboardInfo {
         xkb_keymap * keymap = nullptr;
         xkb_state * state = nullptr;
-        std::unordered_set<InputKey> keysPressed{};
+        // Key each held keycode resolved to when pressed, its release reports the same key whatever the modifiers are then
+        std::unordered_map<xkb_keycode_t, InputKey> heldKeys{};
         KeyboardInfo(xkb_context* context,const char * keymapString,xkb_keymap_format format) ;
 
         ~KeyboardInfo() ;
     };
 
+    // Axis events of one wl_pointer frame, sent as a single ScrollEvent when the frame ends
+    struct PendingScroll
+    {
+        Vector2 delta{};
+        Vector2 detents{};
+        ScrollSource source = ScrollSource::Unknown;
+        Flags<ScrollAxis> stopped{};
+        std::uint64_t timestamp = 0;
+        bool active = false;
+        // Index of the event reserved in the staged frame, keeps the scroll where its first axis event arrived
+        std::optional<std::size_t> slot{};
+    };
+
     class WaylandWindowManager final : public IWindowManager
     {
     public:
@@ -43,6 +117,11 @@ namespace rwin
         ~WaylandWindowManager();
         vk::SurfaceKHR CreateSurface(const std::uint64_t& id, const vk::Instance& instance) override;
         std::uint64_t GetEvents(const std::span<WindowEvent>& events) override;
+        std::span<const WindowEvent> PeekEvents() override;
+        void ConsumeEvents(const std::uint64_t& count) override;
+        std::uint64_t GetEvents(const std::uint64_t& id, const std::span<WindowEvent>& events) override;
+        std::span<const WindowEvent> PeekEvents(const std::uint64_t& id) override;
+        void ConsumeEvents(const std::uint64_t& id, const std::uint64_t& count) override;
         std::uint64_t Create(const std::string_view& title, const Extent2D& size,
             const Flags<WindowFlags>& flags) override;
         void Destroy(const std::uint64_t& id) override;
@@ -56,19 +135,73 @@ namespace rwin
         float GetDpi(const std::uint64_t& id) override;
         float GetDefaultDpi() override;
         void PumpEvents() override;
+        void WaitEvents(const std::chrono::nanoseconds& timeout) override;
+        void Sync() override;
+        int GetEventFd() override;
+        bool PrepareRead() override;
+        void Dispatch(const bool& readable) override;
+        void StartInputThread() override;
+        void StopInputThread() override;
+        void SetMotionCoalescing(const MotionCoalescing& coalescing) override;
         void GetRequiredExtensions(std::vector<const char*>& extensions) override;
         void SetHitTestCallback(const std::uint64_t& id,
             const std::function<HitTestResult(const Vector2&)>& callback) override;
         void ClearHitTestCallback(const std::uint64_t& id) override;
         void SetDropCallbacks(const std::uint64_t& id, const DropCallbacks& callbacks) override;
         void ClearDropCallbacks(const std::uint64_t& id) override;
+        void SetEventMask(const std::uint64_t& id, const Flags<WindowEventType>& mask) override;
+        std::uint64_t GetSuppressedEventCount(const std::uint64_t& id) override;
+        InputSnapshot GetInputSnapshot(const std::uint64_t& id) override;
+        void SetUserData(const std::uint64_t& id, void* data) override;
+        void* GetUserData(const std::uint64_t& id) override;
+        void LockPointer(const std::uint64_t& id) override;
+        void ConfinePointer(const std::uint64_t& id, const WindowRect& region) override;
+        void ReleasePointer(const std::uint64_t& id) override;
+        std::span<const MotionSample> GetMotionHistory(const CursorMoveEvent& event) override;
+        void RequestFrame(const std::uint64_t& id) override;
+        WindowState GetState(const std::uint64_t& id) override;
     private:
-        std::unordered_map<std::uint64_t,std::shared_ptr<WindowInfo>> _windows{};
-        std::unordered_map<wl_surface*,std::shared_ptr<WindowInfo>> _surfaceToWindows{};
-        std::unordered_map<const wl_keyboard*,std::shared_ptr<KeyboardInfo>> _keyboards{};
-        IdFactory _idFactory{};
+        SlotMap<WindowInfo> _windows{};
+        std::unique_ptr<KeyboardInfo> _keyboardInfo{};
         WindowInfo * GetWindowInfo(const std::uint64_t& id);
         WindowInfo * GetWindowInfo(wl_surface* surface);
+        void ReadEvents(const std::chrono::nanoseconds& timeout);
+        bool BeginRead();
+        void PushEvent(const WindowEvent& event);
+        void PushText(WindowInfo* info, const std::string_view& text, const std::uint64_t& timestamp);
+        void PushComposition(WindowInfo* info, const std::string_view& text, const std::int32_t& cursorBegin,
+                             const std::int32_t& cursorEnd);
+        void QueueEvent(WindowEvent event);
+        // Holds a pointer event until the frame it belongs to ends
+        void StagePointerEvent(const WindowEvent& event);
+        void StageScroll(const std::uint64_t& timestamp);
+        void FlushPointerFrame();
+        // Hands every window's scroll since the last pump to its snapshot
+        void PublishScroll();
+        // Frees the text of every window whose queue was drained and that has none in flight from the input thread
+        void ReleaseText();
+        void UpdateTextInput(WindowInfo* info);
+        void ReleasePointer(WindowInfo* info);
+        // The relative pointer only exists while some window's mask takes RawMotion
+        void UpdateRelativePointer();
+        // Largest scale of the outputs the surface is on, used until the compositor prefers one
+        void UpdateOutputScale(WindowInfo* info);
+        void SetScale(WindowInfo* info, const float& scale);
+        // Tells the compositor how the buffer maps onto the logical size
+        void ApplyScale(WindowInfo* info);
+        void PushPresented(WindowInfo* info, struct wp_presentation_feedback* feedback, const PresentedEvent& presented);
+        void SetState(WindowInfo* info, const WindowState& state);
+        void UpdateVisibility(WindowInfo* info);
+        void StartRepeat(const xkb_keycode_t& keyCode, const InputKey& key, const std::uint64_t& pressed);
+        void StopRepeat();
+        // Emits every repeat due at or before time, the timer is re-armed for the one after
+        void EmitRepeats(const std::uint64_t& time);
+        void HandleRepeatTimer();
+        void ArmRepeatTimer(const std::uint64_t& deadline);
+        void DrainInputEvents();
+        void FlushInputOverflow();
+        void RunInputThread();
+        void MoveInputToQueue(wl_event_queue* queue);
 
         wl_registry * _registry = nullptr;
         wl_compositor * _compositor = nullptr;
@@ -78,17 +211,84 @@ namespace rwin
         wl_seat * _seat = nullptr;
         wl_keyboard * _keyboard = nullptr;
         wl_pointer * _pointer = nullptr;
+        zwp_input_timestamps_manager_v1 * _timestampsManager = nullptr;
+        zwp_input_timestamps_v1 * _keyboardTimestamps = nullptr;
+        zwp_input_timestamps_v1 * _pointerTimestamps = nullptr;
+        zwp_relative_pointer_manager_v1 * _relativePointerManager = nullptr;
+        zwp_relative_pointer_v1 * _relativePointer = nullptr;
+        zwp_pointer_constraints_v1 * _pointerConstraints = nullptr;
+        wp_presentation * _presentation = nullptr;
+        wp_viewporter * _viewporter = nullptr;
+        wp_fractional_scale_manager_v1 * _fractionalScaleManager = nullptr;
+        std::vector<std::unique_ptr<OutputInfo>> _outputs{};
+        // Clock the presentation timestamps are on, announced by the compositor after binding
+        clockid_t _presentationClock = CLOCK_MONOTONIC;
+        zwp_text_input_manager_v3 * _textInputManager = nullptr;
+        zwp_text_input_v3 * _textInput = nullptr;
+        // Nanosecond times sent ahead of the next keyboard and pointer event, 0 when the compositor did not send one
+        std::uint64_t _keyboardTimestamp = 0;
+        std::uint64_t _pointerTimestamp = 0;
+        PendingScroll _pendingScroll{};
+        std::vector<WindowEvent> _pointerEvents{};
+        std::uint64_t _pointerFrame = 0;
+        // wl_pointer.frame exists from version 5, older seats have staged events flushed as they arrive
+        bool _pointerFrames = true;
+        // Client side key repeat, the compositor only tells us the rate in keys per second and the delay in milliseconds
+        std::int32_t _repeatRate = 25;
+        std::int32_t _repeatDelay = 600;
+        int _repeatFd = -1;
+        xkb_keycode_t _repeatKeyCode = 0;
+        InputKey _repeatKey = InputKey::Unknown;
+        // Time of the next repeat, 0 while no key is repeating
+        std::uint64_t _repeatNext = 0;
+        // Epoll set over the display, the repeat timer and the input thread's ready descriptor, returned by GetEventFd
+        int _eventFd = -1;
         xkb_context* _xkbContext = nullptr;
         wl_display_listener _displayListener{};
         wl_registry_listener _registryListener{};
         wl_seat_listener _seatListener{};
         wl_keyboard_listener _keyboardListener{};
         wl_pointer_listener _pointerListener{};
+        zwp_input_timestamps_v1_listener _timestampsListener{};
+        zwp_text_input_v3_listener _textInputListener{};
+        zwp_relative_pointer_v1_listener _relativePointerListener{};
+        wl_callback_listener _frameCallbackListener{};
+        wl_surface_listener _surfaceListener{};
+        wl_output_listener _outputListener{};
+        wp_fractional_scale_v1_listener _fractionalScaleListener{};
+        wp_presentation_listener _presentationListener{};
+        wp_presentation_feedback_listener _presentFeedbackListener{};
         libdecor_interface _decorInterface{};
         libdecor_frame_interface _frameInterface{};
-        std::list<WindowEvent> _pendingEvents = {};
-        std::uint64_t _cursorFocusedHandle{};
-        std::uint64_t _keyboardFocusedHandle{};
+        // Queues of every window, the global event calls merge these by sequence
+        std::vector<EventQueue*> _eventQueues{};
+        std::uint64_t _eventSequence = 0;
+        // _eventSequence at the end of the last Dispatch, anything newer has not been handed to the caller yet
+        std::uint64_t _dispatchedSequence = 0;
+        MotionCoalescing _motionCoalescing = MotionCoalescing::None;
+        // Input thread state, the thread dispatches the seat objects on their own queue
+        wl_event_queue* _inputQueue = nullptr;
+        std::thread _inputThread{};
+        std::atomic<bool> _inputThreadRunning{false};
+        int _inputWakeFd = -1;
+        int _inputReadyFd = -1;
+        // Held while the input thread dispatches and while windows are created or destroyed
+        std::mutex _windowsMutex{};
+        SpscQueue<WindowEvent> _inputEvents{};
+        // Owned by the input thread, keeps events in order while the consumer is behind
+        std::vector<WindowEvent> _inputOverflow{};
+        bool _inputProduced = false;
+        // Windows holding pointer and keyboard focus, cleared when they are destroyed
+        WindowInfo* _cursorFocus = nullptr;
+        WindowInfo* _keyboardFocus = nullptr;
+        // Surface the text input object entered and the input method state double buffered until done
+        WindowInfo* _textInputFocus = nullptr;
+        bool _textInputEnabled = false;
+        std::string _pendingCommit{};
+        std::string _pendingPreedit{};
+        std::int32_t _pendingPreeditBegin = -1;
+        std::int32_t _pendingPreeditEnd = -1;
+        std::string _preedit{};
     };
 }
 #endif
\ No newline at end of file
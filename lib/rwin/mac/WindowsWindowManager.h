@@ -9,6 +9,11 @@ namespace rwin
     public:
         vk::SurfaceKHR CreateSurface(const std::uint64_t& id, const vk::Instance& instance) override;
         std::uint64_t GetEvents(const std::span<WindowEvent>& events) override;
+        std::span<const WindowEvent> PeekEvents() override;
+        void ConsumeEvents(const std::uint64_t& count) override;
+        std::uint64_t GetEvents(const std::uint64_t& id, const std::span<WindowEvent>& events) override;
+        std::span<const WindowEvent> PeekEvents(const std::uint64_t& id) override;
+        void ConsumeEvents(const std::uint64_t& id, const std::uint64_t& count) override;
         std::uint64_t Create(const std::string_view& title, const Extent2D& size,
             const Flags<WindowFlags>& flags) override;
         void Destroy(const std::uint64_t& id) override;
@@ -22,12 +27,31 @@ namespace rwin
         float GetDpi(const std::uint64_t& id) override;
         float GetDefaultDpi() override;
         void PumpEvents() override;
+        void WaitEvents(const std::chrono::nanoseconds& timeout) override;
+        void Sync() override;
+        int GetEventFd() override;
+        bool PrepareRead() override;
+        void Dispatch(const bool& readable) override;
+        void StartInputThread() override;
+        void StopInputThread() override;
+        void SetMotionCoalescing(const MotionCoalescing& coalescing) override;
         void GetRequiredExtensions(std::vector<const char*>& extensions) override;
         void SetHitTestCallback(const std::uint64_t& id,
             const std::function<HitTestResult(const Vector2&)>& callback) override;
         void ClearHitTestCallback(const std::uint64_t& id) override;
         void SetDropCallbacks(const std::uint64_t& id, const DropCallbacks& callbacks) override;
         void ClearDropCallbacks(const std::uint64_t& id) override;
+        void SetEventMask(const std::uint64_t& id, const Flags<WindowEventType>& mask) override;
+        std::uint64_t GetSuppressedEventCount(const std::uint64_t& id) override;
+        InputSnapshot GetInputSnapshot(const std::uint64_t& id) override;
+        void SetUserData(const std::uint64_t& id, void* data) override;
+        void* GetUserData(const std::uint64_t& id) override;
+        void LockPointer(const std::uint64_t& id) override;
+        void ConfinePointer(const std::uint64_t& id, const WindowRect& region) override;
+        void ReleasePointer(const std::uint64_t& id) override;
+        std::span<const MotionSample> GetMotionHistory(const CursorMoveEvent& event) override;
+        void RequestFrame(const std::uint64_t& id) override;
+        WindowState GetState(const std::uint64_t& id) override;
     };
 }
 #endif
\ No newline at end of file
@@ -10,6 +10,21 @@ namespace rwin
     std::uint64_t getEvents(const std::span<WindowEvent>& events){
         return IWindowManager::Get()->GetEvents(events);
     }
+    std::span<const WindowEvent> peekEvents(){
+        return IWindowManager::Get()->PeekEvents();
+    }
+    void consumeEvents(const std::uint64_t& count){
+        IWindowManager::Get()->ConsumeEvents(count);
+    }
+    std::uint64_t getWindowEvents(const std::uint64_t& id, const std::span<WindowEvent>& events){
+        return IWindowManager::Get()->GetEvents(id,events);
+    }
+    std::span<const WindowEvent> peekWindowEvents(const std::uint64_t& id){
+        return IWindowManager::Get()->PeekEvents(id);
+    }
+    void consumeWindowEvents(const std::uint64_t& id, const std::uint64_t& count){
+        IWindowManager::Get()->ConsumeEvents(id,count);
+    }
     std::uint64_t createWindow(const std::string_view& title,const Extent2D& size,const Flags<WindowFlags>& flags){
         return IWindowManager::Get()->Create(title,size,flags);
     }
@@ -46,6 +61,30 @@ namespace rwin
     void pumpEvents(){
         IWindowManager::Get()->PumpEvents();
     }
+    void syncEvents(){
+        IWindowManager::Get()->Sync();
+    }
+    int getEventFd(){
+        return IWindowManager::Get()->GetEventFd();
+    }
+    bool prepareRead(){
+        return IWindowManager::Get()->PrepareRead();
+    }
+    void dispatchEvents(const bool& readable){
+        IWindowManager::Get()->Dispatch(readable);
+    }
+    void startInputThread(){
+        IWindowManager::Get()->StartInputThread();
+    }
+    void stopInputThread(){
+        IWindowManager::Get()->StopInputThread();
+    }
+    void waitEvents(const std::chrono::nanoseconds& timeout){
+        IWindowManager::Get()->WaitEvents(timeout);
+    }
+    void setMotionCoalescing(const MotionCoalescing& coalescing){
+        IWindowManager::Get()->SetMotionCoalescing(coalescing);
+    }
     void getRequiredExtensions(std::vector<const char*>& extensions){
         IWindowManager::Get()->GetRequiredExtensions(extensions);
     }
@@ -66,5 +105,60 @@ namespace rwin
         IWindowManager::Get()->ClearDropCallbacks(id);
     }
 
+    void setWindowEventMask(const std::uint64_t& id, const Flags<WindowEventType>& mask)
+    {
+        IWindowManager::Get()->SetEventMask(id, mask);
+    }
+
+    std::uint64_t getWindowSuppressedEventCount(const std::uint64_t& id)
+    {
+        return IWindowManager::Get()->GetSuppressedEventCount(id);
+    }
+
+    InputSnapshot getInputSnapshot(const std::uint64_t& id)
+    {
+        return IWindowManager::Get()->GetInputSnapshot(id);
+    }
+
+    void setWindowUserData(const std::uint64_t& id, void* data)
+    {
+        IWindowManager::Get()->SetUserData(id, data);
+    }
+
+    void* getWindowUserData(const std::uint64_t& id)
+    {
+        return IWindowManager::Get()->GetUserData(id);
+    }
+
+    void lockWindowPointer(const std::uint64_t& id)
+    {
+        IWindowManager::Get()->LockPointer(id);
+    }
+
+    void confineWindowPointer(const std::uint64_t& id, const WindowRect& region)
+    {
+        IWindowManager::Get()->ConfinePointer(id, region);
+    }
+
+    void releaseWindowPointer(const std::uint64_t& id)
+    {
+        IWindowManager::Get()->ReleasePointer(id);
+    }
+
+    std::span<const MotionSample> getMotionHistory(const CursorMoveEvent& event)
+    {
+        return IWindowManager::Get()->GetMotionHistory(event);
+    }
+
+    void requestWindowFrame(const std::uint64_t& id)
+    {
+        IWindowManager::Get()->RequestFrame(id);
+    }
+
+    WindowState getWindowState(const std::uint64_t& id)
+    {
+        return IWindowManager::Get()->GetState(id);
+    }
+
 
 }
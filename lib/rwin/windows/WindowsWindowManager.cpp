@@ -10,6 +10,8 @@
 #endif
 
 #include "WindowsWindowManager.h"
+#include <algorithm>
+#include <array>
 #include <windows.h>
 #include <shlobj.h>
 #include <combaseapi.h>
@@ -255,119 +257,113 @@ namespace rwin
         std::uint64_t _windowId;
         std::shared_ptr<DropContext> _dropContext;
     };
-    InputKey MapVirtualKeyToInputKey(UINT vk, LPARAM lParam)
+    struct VirtualKeyMapping
     {
-        // Extended key flag from lParam
-        bool isExtended = (lParam >> 24) & 0x1;
-
-        switch (vk)
-        {
-        // A-Z
-        case 'A': return InputKey::A;
-        case 'B': return InputKey::B;
-        case 'C': return InputKey::C;
-        case 'D': return InputKey::D;
-        case 'E': return InputKey::E;
-        case 'F': return InputKey::F;
-        case 'G': return InputKey::G;
-        case 'H': return InputKey::H;
-        case 'I': return InputKey::I;
-        case 'J': return InputKey::J;
-        case 'K': return InputKey::K;
-        case 'L': return InputKey::L;
-        case 'M': return InputKey::M;
-        case 'N': return InputKey::N;
-        case 'O': return InputKey::O;
-        case 'P': return InputKey::P;
-        case 'Q': return InputKey::Q;
-        case 'R': return InputKey::R;
-        case 'S': return InputKey::S;
-        case 'T': return InputKey::T;
-        case 'U': return InputKey::U;
-        case 'V': return InputKey::V;
-        case 'W': return InputKey::W;
-        case 'X': return InputKey::X;
-        case 'Y': return InputKey::Y;
-        case 'Z': return InputKey::Z;
-
-        // 0-9
-        case '0': return InputKey::Zero;
-        case '1': return InputKey::One;
-        case '2': return InputKey::Two;
-        case '3': return InputKey::Three;
-        case '4': return InputKey::Four;
-        case '5': return InputKey::Five;
-        case '6': return InputKey::Six;
-        case '7': return InputKey::Seven;
-        case '8': return InputKey::Eight;
-        case '9': return InputKey::Nine;
-
-        // Function keys
-        case VK_F1: return InputKey::F1;
-        case VK_F2: return InputKey::F2;
-        case VK_F3: return InputKey::F3;
-        case VK_F4: return InputKey::F4;
-        case VK_F5: return InputKey::F5;
-        case VK_F6: return InputKey::F6;
-        case VK_F7: return InputKey::F7;
-        case VK_F8: return InputKey::F8;
-        case VK_F9: return InputKey::F9;
-        case VK_F10: return InputKey::F10;
-        case VK_F11: return InputKey::F11;
-        case VK_F12: return InputKey::F12;
-        case VK_F13: return InputKey::F13;
-        case VK_F14: return InputKey::F14;
-        case VK_F15: return InputKey::F15;
-        case VK_F16: return InputKey::F16;
-        case VK_F17: return InputKey::F17;
-        case VK_F18: return InputKey::F18;
-        case VK_F19: return InputKey::F19;
-        case VK_F20: return InputKey::F20;
-        case VK_F21: return InputKey::F21;
-        case VK_F22: return InputKey::F22;
-        case VK_F23: return InputKey::F23;
-        case VK_F24: return InputKey::F24;
+        UINT vk;
+        InputKey key;
+    };
 
+    // Letters, digits and F1 to F24 are contiguous in both enums and are filled in by makeVirtualKeyTable.
+    // Shift, control and alt need lParam to tell left from right so MapVirtualKeyToInputKey handles them
+    constexpr VirtualKeyMapping VIRTUAL_KEY_MAPPINGS[] = {
         // Punctuation and symbols
-        case VK_SPACE: return InputKey::Space;
-        case VK_OEM_7: return InputKey::Apostrophe;
-        case VK_OEM_COMMA: return InputKey::Comma;
-        case VK_OEM_MINUS: return InputKey::Minus;
-        case VK_OEM_PERIOD: return InputKey::Period;
-        case VK_OEM_2: return InputKey::Slash;
-        case VK_OEM_1: return InputKey::Semicolon;
-        case VK_OEM_PLUS: return InputKey::Equal;
-        case VK_OEM_4: return InputKey::LeftBracket;
-        case VK_OEM_5: return InputKey::Backslash;
-        case VK_OEM_6: return InputKey::RightBracket;
-        case VK_OEM_3: return InputKey::GraveAccent;
+        {VK_SPACE, InputKey::Space},
+        {VK_OEM_7, InputKey::Apostrophe},
+        {VK_OEM_COMMA, InputKey::Comma},
+        {VK_OEM_MINUS, InputKey::Minus},
+        {VK_OEM_PERIOD, InputKey::Period},
+        {VK_OEM_2, InputKey::Slash},
+        {VK_OEM_1, InputKey::Semicolon},
+        {VK_OEM_PLUS, InputKey::Equal},
+        {VK_OEM_4, InputKey::LeftBracket},
+        {VK_OEM_5, InputKey::Backslash},
+        {VK_OEM_6, InputKey::RightBracket},
+        {VK_OEM_3, InputKey::GraveAccent},
 
         // Control keys
-        case VK_ESCAPE: return InputKey::Escape;
-        case VK_RETURN: return InputKey::Enter;
-        case VK_TAB: return InputKey::Tab;
-        case VK_BACK: return InputKey::Backspace;
-        case VK_INSERT: return InputKey::Insert;
-        case VK_DELETE: return InputKey::Delete;
-        case VK_HOME: return InputKey::Home;
-        case VK_END: return InputKey::End;
-        case VK_PRIOR: return InputKey::PageUp;
-        case VK_NEXT: return InputKey::PageDown;
+        {VK_ESCAPE, InputKey::Escape},
+        {VK_RETURN, InputKey::Enter},
+        {VK_TAB, InputKey::Tab},
+        {VK_BACK, InputKey::Backspace},
+        {VK_INSERT, InputKey::Insert},
+        {VK_DELETE, InputKey::Delete},
+        {VK_HOME, InputKey::Home},
+        {VK_END, InputKey::End},
+        {VK_PRIOR, InputKey::PageUp},
+        {VK_NEXT, InputKey::PageDown},
 
         // Arrows
-        case VK_LEFT: return InputKey::Left;
-        case VK_RIGHT: return InputKey::Right;
-        case VK_UP: return InputKey::Up;
-        case VK_DOWN: return InputKey::Down;
+        {VK_LEFT, InputKey::Left},
+        {VK_RIGHT, InputKey::Right},
+        {VK_UP, InputKey::Up},
+        {VK_DOWN, InputKey::Down},
 
         // Locks and pause
-        case VK_CAPITAL: return InputKey::CapsLock;
-        case VK_SCROLL: return InputKey::ScrollLock;
-        case VK_NUMLOCK: return InputKey::NumLock;
-        case VK_SNAPSHOT: return InputKey::PrintScreen;
-        case VK_PAUSE: return InputKey::Pause;
+        {VK_CAPITAL, InputKey::CapsLock},
+        {VK_SCROLL, InputKey::ScrollLock},
+        {VK_NUMLOCK, InputKey::NumLock},
+        {VK_SNAPSHOT, InputKey::PrintScreen},
+        {VK_PAUSE, InputKey::Pause},
+
+        {VK_LWIN, InputKey::LeftSuper},
+        {VK_RWIN, InputKey::RightSuper},
+        {VK_APPS, InputKey::Menu},
+    };
+
+    // Distance of one wheel step, close to what wayland compositors send for a wheel click so deltas match across backends
+    constexpr float WHEEL_STEP_PIXELS = 15.0f;
+
+    // Virtual key codes are a single byte so one table indexed by the code covers all of them
+    constexpr std::array<InputKey, 256> makeVirtualKeyTable()
+    {
+        std::array<InputKey, 256> table{};
+        for (UINT i = 0; i < 26; i++)
+        {
+            table['A' + i] = static_cast<InputKey>(static_cast<UINT>(InputKey::A) + i);
+        }
+
+        for (UINT i = 0; i < 10; i++)
+        {
+            table['0' + i] = static_cast<InputKey>(static_cast<UINT>(InputKey::Zero) + i);
+        }
+
+        for (UINT i = 0; i < 24; i++)
+        {
+            table[VK_F1 + i] = static_cast<InputKey>(static_cast<UINT>(InputKey::F1) + i);
+        }
+
+        for (const auto& mapping : VIRTUAL_KEY_MAPPINGS)
+        {
+            table[mapping.vk] = mapping.key;
+        }
+        return table;
+    }
+
+    constexpr std::array<InputKey, 256> VIRTUAL_KEY_TABLE = makeVirtualKeyTable();
+
+    constexpr bool virtualKeyTableMatchesMappings()
+    {
+        for (const auto& mapping : VIRTUAL_KEY_MAPPINGS)
+        {
+            if (mapping.vk > 0xff || VIRTUAL_KEY_TABLE[mapping.vk] != mapping.key)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(virtualKeyTableMatchesMappings());
+    static_assert(VIRTUAL_KEY_TABLE['W'] == InputKey::W && VIRTUAL_KEY_TABLE['9'] == InputKey::Nine);
+    static_assert(VIRTUAL_KEY_TABLE[VK_F24] == InputKey::F24 && VIRTUAL_KEY_TABLE[VK_SHIFT] == InputKey::Unknown);
+
+    InputKey MapVirtualKeyToInputKey(UINT vk, LPARAM lParam)
+    {
+        // Extended key flag from lParam
+        bool isExtended = (lParam >> 24) & 0x1;
 
-        // Left/Right modifiers
+        switch (vk)
+        {
         case VK_SHIFT:
             {
                 // Distinguish LSHIFT / RSHIFT using scan code
@@ -376,18 +372,47 @@ namespace rwin
             }
         case VK_CONTROL: return isExtended ? InputKey::RightControl : InputKey::LeftControl;
         case VK_MENU: return isExtended ? InputKey::RightAlt : InputKey::LeftAlt;
-        case VK_LWIN: return InputKey::LeftSuper;
-        case VK_RWIN: return InputKey::RightSuper;
-        case VK_APPS: return InputKey::Menu;
+        default: return vk < VIRTUAL_KEY_TABLE.size() ? VIRTUAL_KEY_TABLE[vk] : InputKey::Unknown;
+        }
+    }
+
+    std::string_view encodeUtf8(const char32_t codePoint, char (&buffer)[4])
+    {
+        if (codePoint < 0x80)
+        {
+            buffer[0] = static_cast<char>(codePoint);
+            return {buffer, 1};
+        }
+
+        if (codePoint < 0x800)
+        {
+            buffer[0] = static_cast<char>(0xc0 | codePoint >> 6);
+            buffer[1] = static_cast<char>(0x80 | (codePoint & 0x3f));
+            return {buffer, 2};
+        }
 
-        default: return InputKey::A; // Fallback or unknown
+        if (codePoint < 0x10000)
+        {
+            buffer[0] = static_cast<char>(0xe0 | codePoint >> 12);
+            buffer[1] = static_cast<char>(0x80 | (codePoint >> 6 & 0x3f));
+            buffer[2] = static_cast<char>(0x80 | (codePoint & 0x3f));
+            return {buffer, 3};
         }
+
+        buffer[0] = static_cast<char>(0xf0 | codePoint >> 18);
+        buffer[1] = static_cast<char>(0x80 | (codePoint >> 12 & 0x3f));
+        buffer[2] = static_cast<char>(0x80 | (codePoint >> 6 & 0x3f));
+        buffer[3] = static_cast<char>(0x80 | (codePoint & 0x3f));
+        return {buffer, 4};
     }
 
     LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     {
         auto windowInfo = MANAGER_INSTANCE->GetWindowInfo(hwnd);
         if (windowInfo == nullptr) return DefWindowProc(hwnd, uMsg, wParam, lParam);
+        // Message times come from GetTickCount which is too coarse and on another clock, stamp with steady_clock instead
+        const auto timestamp = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
 
         switch (uMsg)
         {
@@ -444,13 +469,17 @@ namespace rwin
         case WM_MOUSELEAVE:
             {
                 windowInfo->trackingMouse = false;
+                // Releases outside the window are not sent to us
+                windowInfo->input.buttons = 0;
+                if (!windowInfo->Accepts(WindowEventType::CursorFocus)) return 0;
                 WindowEvent ev{};
                 new(&ev.cursorFocus) FocusEvent{
                     .type = WindowEventType::CursorFocus,
                     .windowId = windowInfo->id,
+                    .timestamp = timestamp,
                     .focused = 0,
                 };
-                MANAGER_INSTANCE->pendingEvents.push_back(ev);
+                MANAGER_INSTANCE->PushEvent(windowInfo, ev);
                 return 0;
             }
         case WM_MOUSEMOVE:
@@ -467,13 +496,21 @@ namespace rwin
                     if (TrackMouseEvent(&event))
                     {
                         windowInfo->trackingMouse = true;
-
-                        new(&ev.cursorFocus) FocusEvent{
-                            .type = WindowEventType::CursorFocus,
-                            .windowId = windowInfo->id,
-                            .focused = 1,
+                        windowInfo->input.cursorPosition = Vector2{
+                            static_cast<float>(GET_X_LPARAM(lParam)),
+                            static_cast<float>(GET_Y_LPARAM(lParam))
                         };
-                        MANAGER_INSTANCE->pendingEvents.push_back(ev);
+
+                        if (windowInfo->Accepts(WindowEventType::CursorFocus))
+                        {
+                            new(&ev.cursorFocus) FocusEvent{
+                                .type = WindowEventType::CursorFocus,
+                                .windowId = windowInfo->id,
+                                .timestamp = timestamp,
+                                .focused = 1,
+                            };
+                            MANAGER_INSTANCE->PushEvent(windowInfo, ev);
+                        }
                     }
                     else
                     {
@@ -483,13 +520,20 @@ namespace rwin
 
                 const float x = GET_X_LPARAM(lParam);
                 const float y = GET_Y_LPARAM(lParam);
+                const auto delta = Vector2{x - windowInfo->input.cursorPosition.x, y - windowInfo->input.cursorPosition.y};
+                windowInfo->input.cursorPosition = Vector2{x, y};
+                if (!windowInfo->Accepts(WindowEventType::CursorMove)) return 0;
 
                 new(&ev.cursorMove) CursorMoveEvent{
                     .type = WindowEventType::CursorMove,
                     .windowId = windowInfo->id,
+                    .timestamp = timestamp,
+                    .frame = MANAGER_INSTANCE->pointerFrame++,
                     .position = Vector2{x, y},
+                    .delta = delta,
+                    .samples = 1,
                 };
-                MANAGER_INSTANCE->pendingEvents.push_back(ev);
+                MANAGER_INSTANCE->PushEvent(windowInfo, ev);
                 return 0;
             }
         case WM_LBUTTONDOWN:
@@ -551,25 +595,52 @@ namespace rwin
                 if (GetKeyState(VK_CAPITAL) & 0x0001) modifiers.Add(InputModifier::CapsLock);
                 if (GetKeyState(VK_NUMLOCK) & 0x0001) modifiers.Add(InputModifier::NumLock);
 
+                const auto buttonBit = 1u << static_cast<std::uint32_t>(button);
+                if (isDown)
+                {
+                    windowInfo->input.buttons |= buttonBit;
+                }
+                else
+                {
+                    windowInfo->input.buttons &= ~buttonBit;
+                }
+                windowInfo->input.modifiers = static_cast<InputModifier>(modifiers);
+                if (!windowInfo->Accepts(WindowEventType::CursorButton)) return 0;
+
                 new(&ev.cursorButton) CursorButtonEvent{
                     .type = WindowEventType::CursorButton,
                     .windowId = windowInfo->id,
+                    .timestamp = timestamp,
+                    .frame = MANAGER_INSTANCE->pointerFrame++,
                     .button = button,
                     .state = state,
                     .modifier = static_cast<InputModifier>(modifiers),
                 };
-                MANAGER_INSTANCE->pendingEvents.push_back(ev);
+                MANAGER_INSTANCE->PushEvent(windowInfo, ev);
                 return 0;
             }
         case WM_CHAR:
             {
-                WindowEvent ev{};
-                new(&ev.text) TextEvent{
-                    .type = WindowEventType::Text,
-                    .windowId = windowInfo->id,
-                    .text = static_cast<char16_t>(wParam)
-                };
-                MANAGER_INSTANCE->pendingEvents.push_back(ev);
+                const auto unit = static_cast<char16_t>(wParam);
+                if (unit >= 0xd800 && unit < 0xdc00)
+                {
+                    windowInfo->highSurrogate = unit;
+                    return 0;
+                }
+
+                char32_t codePoint = unit;
+                if (unit >= 0xdc00 && unit < 0xe000)
+                {
+                    // A low surrogate without the high half before it is dropped
+                    if (windowInfo->highSurrogate == 0) return 0;
+                    codePoint = 0x10000 + ((static_cast<char32_t>(windowInfo->highSurrogate) - 0xd800) << 10) + (unit - 0xdc00);
+                }
+                windowInfo->highSurrogate = 0;
+
+                // Enter, Tab, Backspace and control chords produce control characters, those are left to key events
+                if (codePoint < 0x20 || codePoint == 0x7f) return 0;
+                char buffer[4];
+                MANAGER_INSTANCE->PushText(windowInfo, encodeUtf8(codePoint, buffer), timestamp);
                 return 0;
             }
         case WM_KEYDOWN:
@@ -600,46 +671,157 @@ namespace rwin
 
                 evt.key.modifier = static_cast<InputModifier>(modifiers);
 
+                windowInfo->input.keys.set(static_cast<std::size_t>(key), state != InputState::Released);
+                windowInfo->input.modifiers = static_cast<InputModifier>(modifiers);
+                if (!windowInfo->Accepts(WindowEventType::Key)) return 0;
+
                 WindowEvent ev{};
                 new(&ev.key) KeyEvent{
                     .type = WindowEventType::Key,
                     .windowId = windowInfo->id,
+                    .timestamp = timestamp,
                     .key = key,
                     .state = state,
                     .modifier = static_cast<InputModifier>(modifiers),
                 };
-                MANAGER_INSTANCE->pendingEvents.push_back(ev);
+                MANAGER_INSTANCE->PushEvent(windowInfo, ev);
                 // Now dispatch or store evt...
                 // Example: processEvent(evt);
                 return 0;
             }
+        case WM_MOUSEWHEEL:
+        case WM_MOUSEHWHEEL:
+            {
+                // Wheel deltas are positive away from the user, events use positive for down like wayland
+                const auto steps = static_cast<float>(GET_WHEEL_DELTA_WPARAM(wParam)) / WHEEL_DELTA;
+                const auto detents = uMsg == WM_MOUSEHWHEEL ? Vector2{steps, 0} : Vector2{0, -steps};
+                const auto delta = Vector2{detents.x * WHEEL_STEP_PIXELS, detents.y * WHEEL_STEP_PIXELS};
+                windowInfo->scroll.Add(delta);
+                if (!windowInfo->Accepts(WindowEventType::Scroll)) return 0;
+
+                // Wheel messages carry screen coordinates, high resolution wheels send fractions of WHEEL_DELTA
+                POINT point{GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam)};
+                ScreenToClient(hwnd, &point);
+                WindowEvent ev{};
+                new(&ev.scroll) ScrollEvent{
+                    .type = WindowEventType::Scroll,
+                    .windowId = windowInfo->id,
+                    .timestamp = timestamp,
+                    .frame = MANAGER_INSTANCE->pointerFrame++,
+                    .position = {static_cast<float>(point.x), static_cast<float>(point.y)},
+                    .delta = delta,
+                    .detents = detents,
+                    .source = ScrollSource::Wheel,
+                    .stopped = static_cast<ScrollAxis>(0),
+                };
+                MANAGER_INSTANCE->PushEvent(windowInfo, ev);
+                return 0;
+            }
+        case WM_KILLFOCUS:
+            {
+                // Key releases go to whichever window has focus next
+                windowInfo->input.keys.reset();
+                if (windowInfo->cursorClip)
+                {
+                    ClipCursor(nullptr);
+                }
+            }
+            break;
+        case WM_SETFOCUS:
+            MANAGER_INSTANCE->ApplyCursorClip(windowInfo);
+            break;
+        case WM_ACTIVATE:
+            windowInfo->active = LOWORD(wParam) != WA_INACTIVE;
+            MANAGER_INSTANCE->UpdateState(windowInfo, timestamp);
+            break;
+        case WM_WINDOWPOSCHANGED:
+            // Sent after every show, hide, minimize, maximize and restore, DefWindowProc still turns it into WM_SIZE
+            MANAGER_INSTANCE->UpdateState(windowInfo, timestamp);
+            break;
+        case WM_INPUT:
+            {
+                RAWINPUT raw{};
+                UINT size = sizeof(raw);
+                if (GetRawInputData(reinterpret_cast<HRAWINPUT>(lParam), RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) ==
+                    static_cast<UINT>(-1) || raw.header.dwType != RIM_TYPEMOUSE)
+                {
+                    break;
+                }
+
+                // Tablets and remote sessions report absolute positions, those have no raw delta
+                const auto& mouse = raw.data.mouse;
+                if ((mouse.usFlags & MOUSE_MOVE_ABSOLUTE) != 0 || (mouse.lLastX == 0 && mouse.lLastY == 0) ||
+                    !windowInfo->Accepts(WindowEventType::RawMotion))
+                {
+                    break;
+                }
+
+                // Raw input comes before pointer ballistics, both deltas are the unaccelerated device counts
+                const Vector2 delta{static_cast<float>(mouse.lLastX), static_cast<float>(mouse.lLastY)};
+                WindowEvent ev{};
+                new(&ev.rawMotion) RawMotionEvent{
+                    .type = WindowEventType::RawMotion,
+                    .windowId = windowInfo->id,
+                    .timestamp = timestamp,
+                    .frame = MANAGER_INSTANCE->pointerFrame++,
+                    .delta = delta,
+                    .unaccelerated = delta,
+                };
+                MANAGER_INSTANCE->PushEvent(windowInfo, ev);
+            }
+            // DefWindowProc has to see WM_INPUT to release the input data
+            break;
         case WM_SIZE:
             {
+                if (!windowInfo->Accepts(WindowEventType::Resize)) break;
                 WindowEvent ev{};
                 new(&ev.resize) ResizeEvent{
                     .type = WindowEventType::Resize,
                     .windowId = windowInfo->id,
+                    .timestamp = timestamp,
                     .size = MANAGER_INSTANCE->GetClientSize(windowInfo->id)
                 };
-                if (!MANAGER_INSTANCE->pendingEvents.empty() && MANAGER_INSTANCE->pendingEvents.back().info.type ==
-                    WindowEventType::Resize)
+                if (!windowInfo->events.Empty() && windowInfo->events.Back().info.type == WindowEventType::Resize)
                 {
-                    MANAGER_INSTANCE->pendingEvents.back() = ev;
+                    auto& back = windowInfo->events.Back();
+                    back.resize.timestamp = ev.resize.timestamp;
+                    back.resize.size = ev.resize.size;
                 }
                 else
                 {
-                    MANAGER_INSTANCE->pendingEvents.push_back(ev);
+                    MANAGER_INSTANCE->PushEvent(windowInfo, ev);
                 }
             }
             break;
+        case WM_DPICHANGED:
+            {
+                // The suggested rect keeps the window the same physical size on the new monitor
+                const auto suggested = reinterpret_cast<const RECT*>(lParam);
+                SetWindowPos(hwnd, nullptr, suggested->left, suggested->top, suggested->right - suggested->left,
+                             suggested->bottom - suggested->top, SWP_NOZORDER | SWP_NOACTIVATE);
+                if (!windowInfo->Accepts(WindowEventType::ScaleChanged)) return 0;
+                const auto dpi = static_cast<float>(HIWORD(wParam));
+                WindowEvent ev{};
+                new(&ev.scaleChanged) ScaleChangedEvent{
+                    .type = WindowEventType::ScaleChanged,
+                    .windowId = windowInfo->id,
+                    .timestamp = timestamp,
+                    .scale = dpi / static_cast<float>(USER_DEFAULT_SCREEN_DPI),
+                    .dpi = dpi,
+                };
+                MANAGER_INSTANCE->PushEvent(windowInfo, ev);
+                return 0;
+            }
         case WM_CLOSE:
             {
+                if (!windowInfo->Accepts(WindowEventType::Close)) return 0;
                 WindowEvent ev{};
                 new(&ev.close) CloseEvent{
                     .type = WindowEventType::Close,
                     .windowId = windowInfo->id,
+                    .timestamp = timestamp,
                 };
-                MANAGER_INSTANCE->pendingEvents.push_back(ev);
+                MANAGER_INSTANCE->PushEvent(windowInfo, ev);
                 return 0;
             }
             break;
@@ -663,6 +845,7 @@ namespace rwin
             wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
             RegisterClass(&wc);
         }
+
         MANAGER_INSTANCE = this;
     }
 
@@ -691,27 +874,80 @@ namespace rwin
 
     std::uint64_t WindowsWindowManager::GetEvents(const std::span<WindowEvent>& events)
     {
-        std::uint64_t gotten = 0;
-        for (auto i = 0; i < events.size(); i++)
+        return PopOrdered(_eventQueues, events);
+    }
+
+    std::span<const WindowEvent> WindowsWindowManager::PeekEvents()
+    {
+        std::size_t count = 0;
+        if (const auto queue = FindOldestRun(_eventQueues, count))
         {
-            if (pendingEvents.empty())
-            {
-                break;
-            }
+            return queue->Peek().first(count);
+        }
+        return {};
+    }
+
+    void WindowsWindowManager::ConsumeEvents(const std::uint64_t& count)
+    {
+        // Nothing older can be queued between a peek and this call so the run found here is the one that was peeked
+        std::size_t run = 0;
+        if (const auto queue = FindOldestRun(_eventQueues, run))
+        {
+            queue->Consume(std::min<std::size_t>(count, run));
+        }
+    }
+
+    std::uint64_t WindowsWindowManager::GetEvents(const std::uint64_t& id, const std::span<WindowEvent>& events)
+    {
+        if (const auto info = GetWindowInfo(id))
+        {
+            return info->events.Pop(events);
+        }
+        return 0;
+    }
 
-            const auto event = pendingEvents.front();
+    std::span<const WindowEvent> WindowsWindowManager::PeekEvents(const std::uint64_t& id)
+    {
+        if (const auto info = GetWindowInfo(id))
+        {
+            return info->events.Peek();
+        }
+        return {};
+    }
 
-            pendingEvents.pop_front();
-            events[i] = event;
-            gotten++;
+    void WindowsWindowManager::ConsumeEvents(const std::uint64_t& id, const std::uint64_t& count)
+    {
+        if (const auto info = GetWindowInfo(id))
+        {
+            info->events.Consume(count);
         }
-        return gotten;
+    }
+
+    void WindowsWindowManager::PushEvent(WindowInfo* info, WindowEvent event)
+    {
+        event.info.sequence = _eventSequence++;
+        info->events.Push(event);
+    }
+
+    void WindowsWindowManager::PushText(WindowInfo* info, const std::string_view& text, const std::uint64_t& timestamp)
+    {
+        if (text.empty() || !info->Accepts(WindowEventType::Text)) return;
+        const auto stored = info->events.StoreText(text);
+        WindowEvent ev{};
+        new(&ev.text) TextEvent{
+            .type = WindowEventType::Text,
+            .windowId = info->id,
+            .timestamp = timestamp,
+            .text = stored.data(),
+            .length = static_cast<std::uint32_t>(stored.size()),
+        };
+        PushEvent(info, ev);
     }
 
     std::uint64_t WindowsWindowManager::Create(const std::string_view& title, const Extent2D& size,
                                                const Flags<WindowFlags>& flags)
     {
-        auto windowId = _idFactory.New();
+        const auto windowId = _windows.Emplace();
         auto windowFlags = WS_SYSMENU;
 
         if (flags.Has(WindowFlags::Resizable))
@@ -747,6 +983,13 @@ namespace rwin
             nullptr
         );
 
+        // Generations start at 1 so 0 never resolves, callers get a handle every lookup rejects
+        if (hwnd == nullptr)
+        {
+            _windows.Erase(windowId);
+            return 0;
+        }
+
         if (flags.Has(WindowFlags::Focused))
         {
             SetFocus(hwnd);
@@ -765,26 +1008,41 @@ namespace rwin
             RegisterDragDrop(hwnd, dropTarget);
         }
 
-        _windows.emplace(windowId, WindowInfo{windowId, hwnd, false,dropTarget});
-        _hwndToWindowId.emplace(hwnd, windowId);
+        const auto info = _windows.Get(windowId);
+        info->id = windowId;
+        info->hwnd = hwnd;
+        info->dropTarget = dropTarget;
+        info->events.SetMotionCoalescing(_motionCoalescing);
+        _eventQueues.push_back(&info->events);
+        // The 64 bit handle does not fit a LONG_PTR on 32 bit builds, the info never moves while the window lives
+        SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(info));
+        // ShowWindow ran before the window could be found from its messages
+        info->active = GetForegroundWindow() == hwnd;
+        UpdateState(info, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count()));
         return windowId;
     }
 
 
     void WindowsWindowManager::Destroy(const std::uint64_t& id)
     {
-        if (const auto info = _windows.find(id); info != _windows.end())
+        if (const auto info = GetWindowInfo(id))
         {
-            const auto hwnd = info->second.hwnd;
-            if (info->second.dropTarget != nullptr)
+            const auto hwnd = info->hwnd;
+            if (info->dropTarget != nullptr)
             {
                 RevokeDragDrop(hwnd);
-                info->second.dropTarget->Release();
-                info->second.dropTarget = nullptr;
+                info->dropTarget->Release();
+                info->dropTarget = nullptr;
+            }
+            if (info->cursorClip && GetFocus() == hwnd)
+            {
+                ClipCursor(nullptr);
             }
             DestroyWindow(hwnd);
-            _hwndToWindowId.erase(hwnd);
-            _windows.erase(info);
+            std::erase(_eventQueues, &info->events);
+            _windows.Erase(id);
+            UpdateRawInput();
         }
     }
 
@@ -850,6 +1108,15 @@ namespace rwin
         };
     }
 
+    WindowState WindowsWindowManager::GetState(const std::uint64_t& id)
+    {
+        if (const auto info = GetWindowInfo(id))
+        {
+            return info->state;
+        }
+        return WindowState::None;
+    }
+
     void WindowsWindowManager::Show(const std::uint64_t& id)
     {
         if (const auto info = GetWindowInfo(id))
@@ -868,31 +1135,86 @@ namespace rwin
 
     void WindowsWindowManager::PumpEvents()
     {
+        for (const auto queue : _eventQueues)
+        {
+            queue->ReleaseHistory();
+            queue->ReleaseText();
+        }
         MSG msg;
         while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE) > 0)
         {
             TranslateMessage(&msg);
             DispatchMessage(&msg);
         }
+        _pumpedSequence = _eventSequence;
+        _windows.ForEach([](WindowInfo& info)
+        {
+            info.scroll.Publish(info.input);
+        });
     }
 
-    WindowInfo* WindowsWindowManager::GetWindowInfo(const std::uint64_t& id)
+    void WindowsWindowManager::SetMotionCoalescing(const MotionCoalescing& coalescing)
     {
-        if (const auto found = _windows.find(id); found != _windows.end())
+        _motionCoalescing = coalescing;
+        for (const auto queue : _eventQueues)
         {
-            return &found->second;
+            queue->SetMotionCoalescing(coalescing);
         }
-        return nullptr;
     }
 
-    WindowInfo* WindowsWindowManager::GetWindowInfo(HWND hwnd)
+    void WindowsWindowManager::WaitEvents(const std::chrono::nanoseconds& timeout)
     {
-        if (const auto found = _hwndToWindowId.find(hwnd); found != _hwndToWindowId.end())
+        // Events left unread in some queue must not keep waking the caller, only ones queued since the last pump do
+        if (PrepareRead())
         {
-            return GetWindowInfo(found->second);
+            const auto milliseconds = std::chrono::ceil<std::chrono::milliseconds>(timeout).count();
+            const auto wait = timeout == std::chrono::nanoseconds::max()
+                                  ? INFINITE
+                                  : static_cast<DWORD>(std::clamp<std::int64_t>(milliseconds, 0, INFINITE - 1));
+            MsgWaitForMultipleObjectsEx(0, nullptr, wait, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
         }
+        PumpEvents();
+    }
 
-        return nullptr;
+    void WindowsWindowManager::Sync()
+    {
+        PumpEvents();
+    }
+
+    int WindowsWindowManager::GetEventFd()
+    {
+        // The message queue is not a descriptor, reactors have to wait on it with MsgWaitForMultipleObjectsEx
+        return -1;
+    }
+
+    bool WindowsWindowManager::PrepareRead()
+    {
+        return _eventSequence == _pumpedSequence;
+    }
+
+    void WindowsWindowManager::Dispatch(const bool& readable)
+    {
+        PumpEvents();
+    }
+
+    void WindowsWindowManager::StartInputThread()
+    {
+        // Window messages are delivered to the thread that created the window so there is nothing to move
+    }
+
+    void WindowsWindowManager::StopInputThread()
+    {
+    }
+
+    WindowInfo* WindowsWindowManager::GetWindowInfo(const std::uint64_t& id)
+    {
+        return _windows.Get(id);
+    }
+
+    WindowInfo* WindowsWindowManager::GetWindowInfo(HWND hwnd)
+    {
+        // Stored on the window itself, nullptr until Create sets it
+        return reinterpret_cast<WindowInfo*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
     }
 
     void WindowsWindowManager::GetRequiredExtensions(std::vector<const char*>& extensions)
@@ -963,5 +1285,224 @@ namespace rwin
             info->dropCallbacks = {};
         }
     }
+
+    std::span<const MotionSample> WindowsWindowManager::GetMotionHistory(const CursorMoveEvent& event)
+    {
+        if (const auto info = GetWindowInfo(event.windowId))
+        {
+            return info->events.GetMotionHistory(event);
+        }
+        return {};
+    }
+
+    void WindowsWindowManager::RequestFrame(const std::uint64_t& id)
+    {
+        // There is no compositor signal to wait for here, the window can draw again straight away unless nobody can see it
+        if (const auto info = GetWindowInfo(id); info && info->visible && info->Accepts(WindowEventType::FrameReady))
+        {
+            WindowEvent ev{};
+            new(&ev.frameReady) FrameReadyEvent{
+                .type = WindowEventType::FrameReady,
+                .windowId = info->id,
+                .timestamp = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count()),
+            };
+            PushEvent(info, ev);
+        }
+    }
+
+    void WindowsWindowManager::LockPointer(const std::uint64_t& id)
+    {
+        if (const auto info = GetWindowInfo(id))
+        {
+            POINT cursor{};
+            GetCursorPos(&cursor);
+            ScreenToClient(info->hwnd, &cursor);
+            info->cursorClip = RECT{cursor.x, cursor.y, cursor.x + 1, cursor.y + 1};
+            ApplyCursorClip(info);
+        }
+    }
+
+    void WindowsWindowManager::ConfinePointer(const std::uint64_t& id, const WindowRect& region)
+    {
+        if (const auto info = GetWindowInfo(id))
+        {
+            info->cursorClip = RECT{
+                region.position.x,
+                region.position.y,
+                region.position.x + static_cast<LONG>(region.extent.width),
+                region.position.y + static_cast<LONG>(region.extent.height)
+            };
+            ApplyCursorClip(info);
+        }
+    }
+
+    void WindowsWindowManager::ReleasePointer(const std::uint64_t& id)
+    {
+        if (const auto info = GetWindowInfo(id); info && info->cursorClip)
+        {
+            info->cursorClip.reset();
+            if (GetFocus() == info->hwnd)
+            {
+                ClipCursor(nullptr);
+            }
+        }
+    }
+
+    void WindowsWindowManager::UpdateState(WindowInfo* info, const std::uint64_t& timestamp)
+    {
+        auto state = static_cast<std::uint32_t>(info->active ? WindowState::Active : WindowState::None);
+        if (IsZoomed(info->hwnd))
+        {
+            state |= static_cast<std::uint32_t>(WindowState::Maximized);
+        }
+        if (IsIconic(info->hwnd))
+        {
+            state |= static_cast<std::uint32_t>(WindowState::Minimized) | static_cast<std::uint32_t>(WindowState::Suspended);
+        }
+
+        const auto previous = info->state;
+        if (static_cast<WindowState>(state) != previous)
+        {
+            info->state = static_cast<WindowState>(state);
+            const auto gained = state & ~static_cast<std::uint32_t>(previous);
+            if ((gained & static_cast<std::uint32_t>(WindowState::Minimized)) != 0 &&
+                info->Accepts(WindowEventType::Minimize))
+            {
+                WindowEvent ev{};
+                new(&ev.minimize) MinimizeEvent{
+                    .type = WindowEventType::Minimize,
+                    .windowId = info->id,
+                    .timestamp = timestamp,
+                };
+                PushEvent(info, ev);
+            }
+
+            if ((gained & static_cast<std::uint32_t>(WindowState::Maximized)) != 0 &&
+                info->Accepts(WindowEventType::Maximize))
+            {
+                WindowEvent ev{};
+                new(&ev.maximize) MaximizeEvent{
+                    .type = WindowEventType::Maximize,
+                    .windowId = info->id,
+                    .timestamp = timestamp,
+                };
+                PushEvent(info, ev);
+            }
+
+            if (info->Accepts(WindowEventType::StateChanged))
+            {
+                WindowEvent ev{};
+                new(&ev.stateChanged) StateChangedEvent{
+                    .type = WindowEventType::StateChanged,
+                    .windowId = info->id,
+                    .timestamp = timestamp,
+                    .state = info->state,
+                    .previous = previous,
+                };
+                PushEvent(info, ev);
+            }
+        }
+
+        const auto visible = IsWindowVisible(info->hwnd) && !IsIconic(info->hwnd);
+        if (visible == info->visible) return;
+        info->visible = visible;
+        if (!info->Accepts(WindowEventType::VisibilityChanged)) return;
+        WindowEvent ev{};
+        new(&ev.visibilityChanged) VisibilityChangedEvent{
+            .type = WindowEventType::VisibilityChanged,
+            .windowId = info->id,
+            .timestamp = timestamp,
+            .visible = visible,
+        };
+        PushEvent(info, ev);
+    }
+
+    void WindowsWindowManager::ApplyCursorClip(WindowInfo* info)
+    {
+        if (!info->cursorClip || GetFocus() != info->hwnd)
+        {
+            return;
+        }
+
+        // Kept in client coordinates and mapped to the screen each time focus returns
+        POINT corners[2]{
+            {info->cursorClip->left, info->cursorClip->top},
+            {info->cursorClip->right, info->cursorClip->bottom}
+        };
+        MapWindowPoints(info->hwnd, nullptr, corners, 2);
+        const RECT clip{corners[0].x, corners[0].y, corners[1].x, corners[1].y};
+        ClipCursor(&clip);
+    }
+
+    void WindowsWindowManager::SetEventMask(const std::uint64_t& id, const Flags<WindowEventType>& mask)
+    {
+        if (const auto info = GetWindowInfo(id))
+        {
+            info->eventMask = mask;
+            UpdateRawInput();
+        }
+    }
+
+    void WindowsWindowManager::UpdateRawInput()
+    {
+        auto wanted = false;
+        _windows.ForEach([&wanted](const WindowInfo& info)
+        {
+            wanted = wanted || info.eventMask.Has(WindowEventType::RawMotion);
+        });
+
+        if (wanted == _rawInputRegistered)
+        {
+            return;
+        }
+
+        // Mouse raw input for RawMotion, sent to whichever of our windows has focus
+        const RAWINPUTDEVICE mouse{
+            .usUsagePage = 0x01,
+            .usUsage = 0x02,
+            .dwFlags = wanted ? 0u : static_cast<DWORD>(RIDEV_REMOVE),
+            .hwndTarget = nullptr
+        };
+        if (RegisterRawInputDevices(&mouse, 1, sizeof(mouse)))
+        {
+            _rawInputRegistered = wanted;
+        }
+    }
+
+    std::uint64_t WindowsWindowManager::GetSuppressedEventCount(const std::uint64_t& id)
+    {
+        if (const auto info = GetWindowInfo(id))
+        {
+            return info->suppressedEvents.load(std::memory_order_relaxed);
+        }
+        return 0;
+    }
+
+    InputSnapshot WindowsWindowManager::GetInputSnapshot(const std::uint64_t& id)
+    {
+        if (const auto info = GetWindowInfo(id))
+        {
+            return info->input;
+        }
+        return {};
+    }
+
+    void WindowsWindowManager::SetUserData(const std::uint64_t& id, void* data)
+    {
+        if (const auto info = GetWindowInfo(id))
+        {
+            info->userData = data;
+        }
+    }
+
+    void* WindowsWindowManager::GetUserData(const std::uint64_t& id)
+    {
+        if (const auto info = GetWindowInfo(id))
+        {
+            return info->userData;
+        }
+        return nullptr;
+    }
 }
 #endif
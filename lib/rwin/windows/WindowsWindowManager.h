@@ -2,10 +2,12 @@
 #include "rwin/macros.h"
 
 #ifdef RWIN_PLATFORM_WIN
-#include "rwin/IdFactory.h"
+#include "rwin/EventQueue.h"
 #include "rwin/IWindowManager.h"
-#include <list>
+#include "rwin/ScrollAccumulator.h"
+#include "rwin/SlotMap.h"
 #include <ObjectArray.h>
+#include <atomic>
 #include <string>
 #include <optional>
 #include <unordered_map>
@@ -19,8 +21,30 @@ namespace rwin
         HWND hwnd{nullptr};
         bool trackingMouse{false};
         IDropTarget* dropTarget{nullptr};
+        InputSnapshot input{};
+        ScrollAccumulator scroll{};
+        // First half of a surrogate pair, WM_CHAR delivers characters outside the BMP in two messages
+        char16_t highSurrogate = 0;
+        // Client rectangle the cursor is clipped to while the window has focus, set by LockPointer and ConfinePointer
+        std::optional<RECT> cursorClip{};
+        WindowState state = WindowState::None;
+        // Set by WM_ACTIVATE, the foreground window is not updated yet while it is handled
+        bool active = false;
+        bool visible = false;
         std::optional<DropCallbacks> dropCallbacks{};
         std::optional<std::function<HitTestResult(const Vector2&)>> hitTestFunction{};
+        Flags<WindowEventType> eventMask{DEFAULT_EVENT_MASK};
+        std::atomic<std::uint64_t> suppressedEvents{0};
+        EventQueue events{};
+        void* userData = nullptr;
+
+        // Counts the event as suppressed when its type is masked out
+        bool Accepts(const WindowEventType& type)
+        {
+            if (eventMask.Has(type)) return true;
+            suppressedEvents.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
     };
 
     class WindowsWindowManager final : public IWindowManager {
@@ -29,6 +53,11 @@ namespace rwin
         ~WindowsWindowManager() override;
         vk::SurfaceKHR CreateSurface(const std::uint64_t& id, const vk::Instance& instance) override;
         std::uint64_t GetEvents(const std::span<WindowEvent>& events) override;
+        std::span<const WindowEvent> PeekEvents() override;
+        void ConsumeEvents(const std::uint64_t& count) override;
+        std::uint64_t GetEvents(const std::uint64_t& id, const std::span<WindowEvent>& events) override;
+        std::span<const WindowEvent> PeekEvents(const std::uint64_t& id) override;
+        void ConsumeEvents(const std::uint64_t& id, const std::uint64_t& count) override;
         std::uint64_t Create(const std::string_view& title, const Extent2D& size,
                     const Flags<WindowFlags>& flags) override;
         void Destroy(const std::uint64_t& id) override;
@@ -39,7 +68,22 @@ namespace rwin
         void Hide(const std::uint64_t& id) override;
 
         void PumpEvents() override;
-        std::list<WindowEvent> pendingEvents = {};
+        void WaitEvents(const std::chrono::nanoseconds& timeout) override;
+        void Sync() override;
+        int GetEventFd() override;
+        bool PrepareRead() override;
+        void Dispatch(const bool& readable) override;
+        void StartInputThread() override;
+        void StopInputThread() override;
+        void SetMotionCoalescing(const MotionCoalescing& coalescing) override;
+        void PushEvent(WindowInfo* info, WindowEvent event);
+        void PushText(WindowInfo* info, const std::string_view& text, const std::uint64_t& timestamp);
+        // ClipCursor is global so it is applied when the window gains focus and dropped when it loses it
+        void ApplyCursorClip(WindowInfo* info);
+        // Reads the window's state back from the system and emits what changed
+        void UpdateState(WindowInfo* info, const std::uint64_t& timestamp);
+        // Every pointer message is a frame of its own
+        std::uint64_t pointerFrame = 0;
         WindowInfo * GetWindowInfo(const std::uint64_t& id);
         WindowInfo * GetWindowInfo(HWND hwnd);
         void GetRequiredExtensions(std::vector<const char*>& extensions) override;
@@ -51,11 +95,29 @@ namespace rwin
         float GetDefaultDpi() override;
         void SetDropCallbacks(const std::uint64_t& id, const DropCallbacks& callbacks) override;
         void ClearDropCallbacks(const std::uint64_t& id) override;
+        void SetEventMask(const std::uint64_t& id, const Flags<WindowEventType>& mask) override;
+        std::uint64_t GetSuppressedEventCount(const std::uint64_t& id) override;
+        InputSnapshot GetInputSnapshot(const std::uint64_t& id) override;
+        void SetUserData(const std::uint64_t& id, void* data) override;
+        void* GetUserData(const std::uint64_t& id) override;
+        void LockPointer(const std::uint64_t& id) override;
+        void ConfinePointer(const std::uint64_t& id, const WindowRect& region) override;
+        void ReleasePointer(const std::uint64_t& id) override;
+        std::span<const MotionSample> GetMotionHistory(const CursorMoveEvent& event) override;
+        void RequestFrame(const std::uint64_t& id) override;
+        WindowState GetState(const std::uint64_t& id) override;
 
     private:
-        std::unordered_map<std::uint64_t, WindowInfo> _windows;
-        std::unordered_map<HWND,std::uint64_t> _hwndToWindowId;
-        IdFactory _idFactory{};
+        SlotMap<WindowInfo> _windows{};
+        // Queues of every window, the global event calls merge these by sequence
+        std::vector<EventQueue*> _eventQueues{};
+        std::uint64_t _eventSequence = 0;
+        // _eventSequence at the end of the last pump, anything newer has not been handed to the caller yet
+        std::uint64_t _pumpedSequence = 0;
+        MotionCoalescing _motionCoalescing = MotionCoalescing::None;
+        // Raw mouse input is only registered while some window's mask takes RawMotion
+        bool _rawInputRegistered = false;
+        void UpdateRawInput();
     };
 }
 #endif
\ No newline at end of file
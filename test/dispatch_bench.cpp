@@ -0,0 +1,122 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "rwin/dispatch.h"
+using namespace rwin;
+
+// Mostly motion with keys, buttons and scrolling mixed in, roughly what a busy pump hands an application
+std::vector<WindowEvent> makeEvents(const std::size_t count)
+{
+    std::vector<WindowEvent> events{};
+    events.resize(count);
+    std::uint32_t seed = 1;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        auto& event = events[i];
+        switch (seed >> 28)
+        {
+        case 0:
+        case 1:
+            new(&event.key) KeyEvent{.type = WindowEventType::Key, .key = static_cast<InputKey>(seed % 26 + 1)};
+            break;
+        case 2:
+            new(&event.cursorButton) CursorButtonEvent{.type = WindowEventType::CursorButton};
+            break;
+        case 3:
+            new(&event.scroll) ScrollEvent{.type = WindowEventType::Scroll, .delta = {0, 1}};
+            break;
+        case 4:
+            new(&event.resize) ResizeEvent{.type = WindowEventType::Resize, .size = {seed % 1920, seed % 1080}};
+            break;
+        default:
+            new(&event.cursorMove) CursorMoveEvent{.type = WindowEventType::CursorMove, .delta = {1, 2}};
+            break;
+        }
+    }
+    return events;
+}
+
+template <typename Fn>
+double timePerEvent(const std::vector<WindowEvent>& events, const int rounds, Fn&& fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (auto round = 0; round < rounds; round++)
+    {
+        fn();
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(events.size() * rounds);
+}
+
+int main()
+{
+    constexpr auto rounds = 50;
+    const auto events = makeEvents(1 << 20);
+    std::uint64_t switchSum = 0;
+    std::uint64_t dispatchSum = 0;
+
+    const auto switchTime = timePerEvent(events, rounds, [&events, &switchSum]
+    {
+        for (const auto& event : events)
+        {
+            switch (event.info.type)
+            {
+            case WindowEventType::Key:
+                switchSum += static_cast<std::uint64_t>(event.key.key);
+                break;
+            case WindowEventType::CursorButton:
+                switchSum += 3;
+                break;
+            case WindowEventType::Scroll:
+                switchSum += static_cast<std::uint64_t>(event.scroll.delta.y);
+                break;
+            case WindowEventType::Resize:
+                switchSum += event.resize.size.width;
+                break;
+            case WindowEventType::CursorMove:
+                switchSum += static_cast<std::uint64_t>(event.cursorMove.delta.x + event.cursorMove.delta.y);
+                break;
+            default:
+                break;
+            }
+        }
+    });
+
+    const auto dispatchTime = timePerEvent(events, rounds, [&events, &dispatchSum]
+    {
+        dispatch(std::span<const WindowEvent>{events}, overloaded{
+                     [&dispatchSum](const KeyEvent& event)
+                     {
+                         dispatchSum += static_cast<std::uint64_t>(event.key);
+                     },
+                     [&dispatchSum](const CursorButtonEvent&)
+                     {
+                         dispatchSum += 3;
+                     },
+                     [&dispatchSum](const ScrollEvent& event)
+                     {
+                         dispatchSum += static_cast<std::uint64_t>(event.delta.y);
+                     },
+                     [&dispatchSum](const ResizeEvent& event)
+                     {
+                         dispatchSum += event.size.width;
+                     },
+                     [&dispatchSum](const CursorMoveEvent& event)
+                     {
+                         dispatchSum += static_cast<std::uint64_t>(event.delta.x + event.delta.y);
+                     }
+                 });
+    });
+
+    std::cout << "switch:   " << switchTime << " ns/event" << std::endl;
+    std::cout << "dispatch: " << dispatchTime << " ns/event" << std::endl;
+    // Both loops have to see the same events, a difference means dispatch skipped or misrouted one
+    if (switchSum != dispatchSum)
+    {
+        std::cerr << "dispatch and switch disagree: " << dispatchSum << " != " << switchSum << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "rwin/EventQueue.h"
+using namespace rwin;
+
+bool check(const bool condition, const char* message)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << message << std::endl;
+    }
+    return condition;
+}
+
+WindowEvent makeMove(const float x, const std::uint64_t timestamp)
+{
+    WindowEvent event{};
+    new(&event.cursorMove) CursorMoveEvent{
+        .type = WindowEventType::CursorMove,
+        .windowId = 1,
+        .timestamp = timestamp,
+        .position = {x, 0},
+        .delta = {1, 0},
+        .samples = 1,
+    };
+    return event;
+}
+
+WindowEvent makeText(const std::string_view& text, const std::uint64_t windowId, const std::uint64_t timestamp)
+{
+    WindowEvent event{};
+    new(&event.text) TextEvent{
+        .type = WindowEventType::Text,
+        .windowId = windowId,
+        .timestamp = timestamp,
+        .text = text.data(),
+        .length = static_cast<std::uint32_t>(text.size()),
+    };
+    return event;
+}
+
+WindowEvent makeKey(const std::uint64_t timestamp)
+{
+    WindowEvent event{};
+    new(&event.key) KeyEvent{.type = WindowEventType::Key, .windowId = 1, .timestamp = timestamp};
+    return event;
+}
+
+int main()
+{
+    auto passed = true;
+    std::vector<WindowEvent> popped(64);
+
+    {
+        // Without coalescing every event is its own sample and nothing is recorded
+        EventQueue queue{4};
+        for (auto i = 0; i < 100; i++)
+        {
+            queue.Push(makeMove(static_cast<float>(i), i + 1));
+        }
+        passed &= check(queue.Size() == 100, "uncoalesced motion was merged");
+        passed &= check(queue.GetMotionHistory(queue.Peek().front().cursorMove).empty(),
+                        "history was recorded without coalescing");
+    }
+
+    {
+        EventQueue queue{4};
+        queue.SetMotionCoalescing(MotionCoalescing::LatestWithDelta);
+        for (auto i = 0; i < 5; i++)
+        {
+            queue.Push(makeMove(static_cast<float>(i), i + 1));
+        }
+        queue.Push(makeKey(6));
+        for (auto i = 0; i < 3; i++)
+        {
+            queue.Push(makeMove(static_cast<float>(10 + i), 7 + i));
+        }
+        passed &= check(queue.Size() == 3, "runs were not merged");
+
+        passed &= check(queue.Pop(std::span{popped}.first(1)) == 1, "pop failed");
+        const auto first = popped[0].cursorMove;
+        const auto history = queue.GetMotionHistory(first);
+        passed &= check(first.samples == 5 && first.delta.x == 5 && history.size() == 5, "merged run lost samples");
+        for (std::size_t i = 0; i < history.size(); i++)
+        {
+            passed &= check(history[i].timestamp == i + 1, "samples out of order");
+        }
+
+        // Popped events keep their samples until the next release, the queued run keeps its own past it
+        queue.ReleaseHistory();
+        passed &= check(queue.GetMotionHistory(first).empty(), "released samples still resolve");
+        passed &= check(queue.Pop(std::span{popped}.first(2)) == 2, "pop failed");
+        const auto second = popped[1].cursorMove;
+        passed &= check(queue.GetMotionHistory(second).size() == 3, "a queued run lost its samples on release");
+
+        // A stale event has to stay empty when newer motion reuses the positions its samples had
+        queue.ReleaseHistory();
+        for (auto i = 0; i < 8; i++)
+        {
+            queue.Push(makeMove(static_cast<float>(20 + i), 20 + i));
+        }
+        passed &= check(queue.GetMotionHistory(first).empty() && queue.GetMotionHistory(second).empty(),
+                        "a stale event resolved to newer samples");
+    }
+
+    {
+        // An application that never drains keeps only the samples of what is still queued
+        EventQueue queue{4};
+        queue.SetMotionCoalescing(MotionCoalescing::Latest);
+        for (auto pump = 0; pump < 10000; pump++)
+        {
+            queue.Push(makeMove(static_cast<float>(pump), pump * 2 + 1));
+            queue.Push(makeKey(pump * 2 + 2));
+            if (queue.Size() > 8)
+            {
+                queue.Consume(2);
+            }
+            queue.ReleaseHistory();
+        }
+        const auto front = queue.Peek().front();
+        passed &= check(queue.Size() <= 8, "queue grew");
+        passed &= check(front.info.type != WindowEventType::CursorMove || queue.GetMotionHistory(front.cursorMove).size() == 1,
+                        "a queued event lost its samples");
+        passed &= check(queue.GetMotionHistory(makeMove(0, 0).cursorMove).empty(), "a trimmed offset resolved");
+    }
+
+    {
+        // One window is read every pump, the other never, only the unread window may keep its text
+        EventQueue read{4};
+        EventQueue unread{4};
+        const std::string typed = "\xe3\x81\x82 typed";
+        const auto first = unread.StoreText(typed);
+        unread.Push(makeText(first, 2, 1));
+        for (auto pump = 0; pump < 10000; pump++)
+        {
+            for (const auto queue : {&read, &unread})
+            {
+                queue->ReleaseText();
+            }
+            read.Push(makeText(read.StoreText(typed), 1, pump));
+            unread.Push(makeText(unread.StoreText(typed), 2, pump));
+            read.Consume(read.Size());
+        }
+        passed &= check(read.TextSize() == typed.size(), "a drained window kept text of earlier pumps");
+        passed &= check(unread.TextSize() == typed.size() * 10001, "text of queued events was released");
+        passed &= check(unread.Peek().front().text.View() == typed && first == typed, "queued text was overwritten");
+    }
+    return passed ? 0 : 1;
+}
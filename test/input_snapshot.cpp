@@ -0,0 +1,36 @@
+#include <iostream>
+#include "rwin/ScrollAccumulator.h"
+using namespace rwin;
+
+bool check(const bool condition, const char* message)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << message << std::endl;
+    }
+    return condition;
+}
+
+int main()
+{
+    auto passed = true;
+    InputSnapshot input{};
+    ScrollAccumulator scroll{};
+
+    // Axis events the input thread handled before the pump, the pump drains them and the application polls after it
+    scroll.Add({0, 10});
+    scroll.Add({0, 5});
+    scroll.Add({-2, 0});
+    scroll.Publish(input);
+    passed &= check(input.scrollDelta.x == -2 && input.scrollDelta.y == 15, "the pump that delivered the scroll dropped it");
+
+    // Scroll that arrives after the pump belongs to the next one
+    scroll.Add({0, 3});
+    passed &= check(input.scrollDelta.y == 15, "scroll leaked into the pump that already ended");
+    scroll.Publish(input);
+    passed &= check(input.scrollDelta.x == 0 && input.scrollDelta.y == 3, "the next pump did not start from zero");
+
+    scroll.Publish(input);
+    passed &= check(input.scrollDelta.x == 0 && input.scrollDelta.y == 0, "a pump without scroll kept the old one");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <vector>
+#include "linux/Keysyms.h"
+using namespace rwin;
+
+// The switch xkbKeyToInputKey used before the tables, kept as the reference the tables must agree with
+InputKey legacyKeysymToInputKey(const xkb_keysym_t key)
+{
+    switch (key)
+    {
+    case XKB_KEY_A:
+    case XKB_KEY_a: return InputKey::A;
+    case XKB_KEY_B:
+    case XKB_KEY_b: return InputKey::B;
+    case XKB_KEY_C:
+    case XKB_KEY_c: return InputKey::C;
+    case XKB_KEY_D:
+    case XKB_KEY_d: return InputKey::D;
+    case XKB_KEY_E:
+    case XKB_KEY_e: return InputKey::E;
+    case XKB_KEY_F:
+    case XKB_KEY_f: return InputKey::F;
+    case XKB_KEY_G:
+    case XKB_KEY_g: return InputKey::G;
+    case XKB_KEY_H:
+    case XKB_KEY_h: return InputKey::H;
+    case XKB_KEY_I:
+    case XKB_KEY_i: return InputKey::I;
+    case XKB_KEY_J:
+    case XKB_KEY_j: return InputKey::J;
+    case XKB_KEY_K:
+    case XKB_KEY_k: return InputKey::K;
+    case XKB_KEY_L:
+    case XKB_KEY_l: return InputKey::L;
+    case XKB_KEY_M:
+    case XKB_KEY_m: return InputKey::M;
+    case XKB_KEY_N:
+    case XKB_KEY_n: return InputKey::N;
+    case XKB_KEY_O:
+    case XKB_KEY_o: return InputKey::O;
+    case XKB_KEY_P:
+    case XKB_KEY_p: return InputKey::P;
+    case XKB_KEY_Q:
+    case XKB_KEY_q: return InputKey::Q;
+    case XKB_KEY_R:
+    case XKB_KEY_r: return InputKey::R;
+    case XKB_KEY_S:
+    case XKB_KEY_s: return InputKey::S;
+    case XKB_KEY_T:
+    case XKB_KEY_t: return InputKey::T;
+    case XKB_KEY_U:
+    case XKB_KEY_u: return InputKey::U;
+    case XKB_KEY_V:
+    case XKB_KEY_v: return InputKey::V;
+    case XKB_KEY_W:
+    case XKB_KEY_w: return InputKey::W;
+    case XKB_KEY_X:
+    case XKB_KEY_x: return InputKey::X;
+    case XKB_KEY_Y:
+    case XKB_KEY_y: return InputKey::Y;
+    case XKB_KEY_Z:
+    case XKB_KEY_z: return InputKey::Z;
+
+    case XKB_KEY_0: return InputKey::Zero;
+    case XKB_KEY_1: return InputKey::One;
+    case XKB_KEY_2: return InputKey::Two;
+    case XKB_KEY_3: return InputKey::Three;
+    case XKB_KEY_4: return InputKey::Four;
+    case XKB_KEY_5: return InputKey::Five;
+    case XKB_KEY_6: return InputKey::Six;
+    case XKB_KEY_7: return InputKey::Seven;
+    case XKB_KEY_8: return InputKey::Eight;
+    case XKB_KEY_9: return InputKey::Nine;
+
+    case XKB_KEY_F1: return InputKey::F1;
+    case XKB_KEY_F2: return InputKey::F2;
+    case XKB_KEY_F3: return InputKey::F3;
+    case XKB_KEY_F4: return InputKey::F4;
+    case XKB_KEY_F5: return InputKey::F5;
+    case XKB_KEY_F6: return InputKey::F6;
+    case XKB_KEY_F7: return InputKey::F7;
+    case XKB_KEY_F8: return InputKey::F8;
+    case XKB_KEY_F9: return InputKey::F9;
+    case XKB_KEY_F10: return InputKey::F10;
+    case XKB_KEY_F11: return InputKey::F11;
+    case XKB_KEY_F12: return InputKey::F12;
+    case XKB_KEY_F13: return InputKey::F13;
+    case XKB_KEY_F14: return InputKey::F14;
+    case XKB_KEY_F15: return InputKey::F15;
+    case XKB_KEY_F16: return InputKey::F16;
+    case XKB_KEY_F17: return InputKey::F17;
+    case XKB_KEY_F18: return InputKey::F18;
+    case XKB_KEY_F19: return InputKey::F19;
+    case XKB_KEY_F20: return InputKey::F20;
+    case XKB_KEY_F21: return InputKey::F21;
+    case XKB_KEY_F22: return InputKey::F22;
+    case XKB_KEY_F23: return InputKey::F23;
+    case XKB_KEY_F24: return InputKey::F24;
+
+    case XKB_KEY_space: return InputKey::Space;
+    case XKB_KEY_apostrophe: return InputKey::Apostrophe;
+    case XKB_KEY_comma: return InputKey::Comma;
+    case XKB_KEY_minus: return InputKey::Minus;
+    case XKB_KEY_period: return InputKey::Period;
+    case XKB_KEY_slash: return InputKey::Slash;
+    case XKB_KEY_semicolon: return InputKey::Semicolon;
+    case XKB_KEY_equal: return InputKey::Equal;
+    case XKB_KEY_bracketleft: return InputKey::LeftBracket;
+    case XKB_KEY_backslash: return InputKey::Backslash;
+    case XKB_KEY_bracketright: return InputKey::RightBracket;
+    case XKB_KEY_grave: return InputKey::GraveAccent;
+
+    case XKB_KEY_Escape: return InputKey::Escape;
+    case XKB_KEY_Return: return InputKey::Enter;
+    case XKB_KEY_Tab: return InputKey::Tab;
+    case XKB_KEY_BackSpace: return InputKey::Backspace;
+    case XKB_KEY_Insert: return InputKey::Insert;
+    case XKB_KEY_Delete: return InputKey::Delete;
+    case XKB_KEY_Right: return InputKey::Right;
+    case XKB_KEY_Left: return InputKey::Left;
+    case XKB_KEY_Down: return InputKey::Down;
+    case XKB_KEY_Up: return InputKey::Up;
+    case XKB_KEY_Page_Up: return InputKey::PageUp;
+    case XKB_KEY_Page_Down: return InputKey::PageDown;
+    case XKB_KEY_Home: return InputKey::Home;
+    case XKB_KEY_End: return InputKey::End;
+
+    case XKB_KEY_Caps_Lock: return InputKey::CapsLock;
+    case XKB_KEY_Scroll_Lock: return InputKey::ScrollLock;
+    case XKB_KEY_Num_Lock: return InputKey::NumLock;
+    case XKB_KEY_Print: return InputKey::PrintScreen;
+    case XKB_KEY_Pause: return InputKey::Pause;
+
+    case XKB_KEY_Shift_L: return InputKey::LeftShift;
+    case XKB_KEY_Shift_R: return InputKey::RightShift;
+    case XKB_KEY_Control_L: return InputKey::LeftControl;
+    case XKB_KEY_Control_R: return InputKey::RightControl;
+    case XKB_KEY_Alt_L: return InputKey::LeftAlt;
+    case XKB_KEY_Alt_R: return InputKey::RightAlt;
+    case XKB_KEY_Super_L: return InputKey::LeftSuper;
+    case XKB_KEY_Super_R: return InputKey::RightSuper;
+    case XKB_KEY_Menu: return InputKey::Menu;
+
+    default:
+        return InputKey::Unknown;
+    }
+}
+
+// Keysyms the tables map on purpose where the switch did not
+InputKey expectedDifference(const xkb_keysym_t keysym)
+{
+    switch (keysym)
+    {
+    case XKB_KEY_ISO_Level3_Shift: return InputKey::RightAlt;
+    case XKB_KEY_ISO_Left_Tab: return InputKey::Tab;
+    default: return InputKey::Unknown;
+    }
+}
+
+// Keysyms of someone typing prose, shift for capitals, the odd correction and new lines
+std::vector<xkb_keysym_t> makeTypingTrace()
+{
+    constexpr std::string_view text = "The quick brown fox jumps over the lazy dog, then naps. Typing 42 lines; fixing typos!\n";
+    std::vector<xkb_keysym_t> trace{};
+    for (const auto c : text)
+    {
+        if (c >= 'A' && c <= 'Z')
+        {
+            trace.push_back(XKB_KEY_Shift_L);
+        }
+        switch (c)
+        {
+        case '\n': trace.push_back(XKB_KEY_Return);
+            break;
+        case '!': trace.push_back(XKB_KEY_exclam);
+            break;
+        default: trace.push_back(static_cast<xkb_keysym_t>(c));
+            break;
+        }
+        if (c == ' ' && trace.size() % 7 == 0)
+        {
+            trace.push_back(XKB_KEY_BackSpace);
+        }
+    }
+    return trace;
+}
+
+template <typename Fn>
+double timePerKey(const std::vector<xkb_keysym_t>& trace, const int rounds, std::uint64_t& sum, Fn&& fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (auto round = 0; round < rounds; round++)
+    {
+        for (const auto keysym : trace)
+        {
+            sum += static_cast<std::uint64_t>(fn(keysym));
+        }
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(trace.size() * rounds);
+}
+
+int main()
+{
+    // Keysyms are at most 29 bits, every one of them is compared
+    constexpr xkb_keysym_t lastKeysym = 0x1fffffff;
+    std::uint64_t mismatches = 0;
+    for (xkb_keysym_t keysym = 0; keysym <= lastKeysym; keysym++)
+    {
+        const auto table = lookupKeysym(keysym);
+        auto expected = legacyKeysymToInputKey(keysym);
+        if (expected == InputKey::Unknown)
+        {
+            expected = expectedDifference(keysym);
+        }
+        if (table != expected)
+        {
+            if (mismatches++ < 16)
+            {
+                std::cerr << "keysym 0x" << std::hex << keysym << std::dec << ": table " << static_cast<int>(table) <<
+                    ", switch " << static_cast<int>(expected) << std::endl;
+            }
+        }
+    }
+
+    const auto trace = makeTypingTrace();
+    constexpr auto rounds = 200000;
+    std::uint64_t switchSum = 0;
+    std::uint64_t tableSum = 0;
+    const auto switchTime = timePerKey(trace, rounds, switchSum, legacyKeysymToInputKey);
+    const auto tableTime = timePerKey(trace, rounds, tableSum, lookupKeysym);
+    std::cout << "switch: " << switchTime << " ns/key" << std::endl;
+    std::cout << "table:  " << tableTime << " ns/key" << std::endl;
+
+    if (mismatches != 0 || switchSum != tableSum)
+    {
+        std::cerr << mismatches << " keysyms differ between the table and the switch" << std::endl;
+        return 1;
+    }
+    return 0;
+}
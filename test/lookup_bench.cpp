@@ -0,0 +1,125 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <ranges>
+#include <unordered_map>
+#include <vector>
+#include "rwin/SlotMap.h"
+using namespace rwin;
+
+// Stands in for a wl_surface proxy, wl_surface_get_user_data is a read of the pointer the proxy carries
+struct Surface
+{
+    void* userData = nullptr;
+};
+
+struct Window
+{
+    std::uint64_t id = 0;
+    Surface* surface = nullptr;
+    std::uint64_t events = 0;
+};
+
+// One enter per 64 pointer events, the rest is motion and buttons for the focused window
+constexpr std::size_t ENTER_INTERVAL = 64;
+
+template <typename Fn>
+double timePerEvent(const std::size_t events, Fn&& fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(events);
+}
+
+int main()
+{
+    constexpr std::size_t windowCount = 32;
+    constexpr std::size_t eventCount = 1 << 24;
+    std::vector<Surface> surfaces(windowCount);
+
+    // Before: surfaces and ids resolved through hash maps, the focused window kept as an id
+    std::unordered_map<std::uint64_t, std::shared_ptr<Window>> windowsById{};
+    std::unordered_map<Surface*, std::shared_ptr<Window>> windowsBySurface{};
+    // After: ids resolved through the slot map, surfaces carry their window and focus is cached as a pointer
+    SlotMap<Window> slots{};
+    std::vector<std::uint64_t> ids{};
+    for (std::size_t i = 0; i < windowCount; i++)
+    {
+        const auto window = std::make_shared<Window>(Window{i + 1, &surfaces[i]});
+        windowsById.emplace(window->id, window);
+        windowsBySurface.emplace(&surfaces[i], window);
+
+        const auto id = slots.Emplace();
+        const auto slot = slots.Get(id);
+        slot->id = id;
+        slot->surface = &surfaces[i];
+        surfaces[i].userData = slot;
+        ids.push_back(id);
+    }
+
+    const auto mapTime = timePerEvent(eventCount, [&]
+    {
+        std::uint64_t focusedId = 0;
+        for (std::size_t i = 0; i < eventCount; i++)
+        {
+            if (i % ENTER_INTERVAL == 0)
+            {
+                const auto surface = &surfaces[(i / ENTER_INTERVAL) % windowCount];
+                if (windowsBySurface.contains(surface))
+                {
+                    focusedId = windowsBySurface[surface]->id;
+                }
+            }
+            // The listener finds the focused window, queueing the event finds it again by id
+            if (windowsById.contains(focusedId))
+            {
+                const auto id = windowsById[focusedId]->id;
+                if (windowsById.contains(id))
+                {
+                    windowsById[id]->events++;
+                }
+            }
+        }
+    });
+
+    const auto slotTime = timePerEvent(eventCount, [&]
+    {
+        Window* focus = nullptr;
+        for (std::size_t i = 0; i < eventCount; i++)
+        {
+            if (i % ENTER_INTERVAL == 0)
+            {
+                focus = static_cast<Window*>(surfaces[(i / ENTER_INTERVAL) % windowCount].userData);
+            }
+            if (focus)
+            {
+                if (const auto window = slots.Get(focus->id))
+                {
+                    window->events++;
+                }
+            }
+        }
+    });
+
+    std::uint64_t mapEvents = 0;
+    for (const auto& window : windowsById | std::views::values)
+    {
+        mapEvents += window->events;
+    }
+    std::uint64_t slotEvents = 0;
+    slots.ForEach([&slotEvents](const Window& window)
+    {
+        slotEvents += window.events;
+    });
+
+    std::cout << "hash maps:            " << mapTime << " ns/event" << std::endl;
+    std::cout << "user data + slot map: " << slotTime << " ns/event" << std::endl;
+    if (mapEvents != eventCount || slotEvents != eventCount)
+    {
+        std::cerr << "lost events: " << mapEvents << ", " << slotEvents << " of " << eventCount << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <vulkan/vulkan_core.h>
 #include "rwin/DropCallbacks.h"
+#include "rwin/dispatch.h"
 #include "rwin/rwin.h"
 using namespace rwin;
 
@@ -24,7 +25,6 @@ vk::PhysicalDevice physicalDevice;
 vk::Device device;
 vk::Queue queue;
 std::uint32_t queueFamilyIndex;
-std::unordered_map<std::uint64_t, WindowVulkanInfo> windows;
 
 void destroySwapchain(const std::uint64_t& windowId, WindowVulkanInfo& info)
 {
@@ -84,7 +84,7 @@ void createSwapchain(const std::uint64_t& windowId, WindowVulkanInfo& info)
 void drawWindow(const std::uint64_t& windowId)
 {
     auto clientExtent = getWindowClientSize(windowId);
-    auto& info = windows[windowId];
+    auto& info = *static_cast<WindowVulkanInfo*>(getWindowUserData(windowId));
     auto size = info.extent;
     auto caps = physicalDevice.getSurfaceCapabilitiesKHR(info.surface);
     vk::Extent2D targetSize{};
@@ -157,18 +157,20 @@ void initVulkanWindow(const std::uint64_t& windowId)
     auto surface = createSurface(windowId, instance);
     auto fence = device.createFence({vk::FenceCreateFlagBits::eSignaled});
     auto semaphore = device.createSemaphore({});
-    windows.emplace(windowId, WindowVulkanInfo{fence, semaphore, pool, cmd, surface, {0, 0}});
+    setWindowUserData(windowId, new WindowVulkanInfo{fence, semaphore, pool, cmd, surface, {0, 0}});
 }
 
 void destroyVulkanWindow(const std::uint64_t& windowId)
 {
-    auto& info = windows[windowId];
+    auto& info = *static_cast<WindowVulkanInfo*>(getWindowUserData(windowId));
     device.waitIdle();
     destroySwapchain(windowId, info);
     device.destroyFence(info.renderFence);
     device.destroySemaphore(info.swapchainSemaphore);
     device.destroyCommandPool(info.commandPool);
     instance.destroySurfaceKHR(info.surface);
+    delete &info;
+    setWindowUserData(windowId, nullptr);
 }
 
 void initVulkan()
@@ -300,32 +302,41 @@ int main()
     std::vector<WindowEvent> events{};
     events.resize(64);
     auto quit = false;
+    auto frameReady = true;
     while (!quit)
     {
-        pumpEvents();
-        const auto eventsGotten = getEvents(events);
-        for (auto i = 0; i < eventsGotten; i++)
+        // Sleeps until there is input or the compositor wants the next frame
+        waitEvents();
+        const auto eventsGotten = getWindowEvents(windowId, events);
+        dispatch(std::span<const WindowEvent>{events.data(), eventsGotten}, overloaded{
+                     [&quit](const CloseEvent&)
+                     {
+                         quit = true;
+                     },
+                     [&frameReady](const FrameReadyEvent&)
+                     {
+                         frameReady = true;
+                     },
+                     [&frameReady](const VisibilityChangedEvent& event)
+                     {
+                         // No FrameReady comes while the window is hidden, draw straight away once it can be seen again
+                         frameReady = event.visible;
+                     },
+                     [](const KeyEvent& event)
+                     {
+                         if (event.key == InputKey::W && event.state == InputState::Pressed)
+                         {
+                             std::cout << "W Key Pressed" << std::endl;
+                         }
+                     }
+                 });
+
+        if (frameReady)
         {
-            const auto& event = events[i];
-            if (event.info.windowId != windowId) continue;
-
-            switch (event.info.type)
-            {
-            case WindowEventType::Close:
-                quit = true;
-                break;
-            case WindowEventType::Key:
-                {
-                    if (event.key.key == InputKey::W && event.key.state == InputState::Pressed)
-                    {
-                        std::cout << "W Key Pressed" << std::endl;
-                    }
-                }
-                break;
-            default: ;
-            }
+            frameReady = false;
+            requestWindowFrame(windowId);
+            drawWindow(windowId);
         }
-        drawWindow(windowId);
     }
     destroyVulkanWindow(windowId);
     destroyWindow(windowId);
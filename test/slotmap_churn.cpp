@@ -0,0 +1,130 @@
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+#include "rwin/SlotMap.h"
+using namespace rwin;
+
+// Live heap bytes, every allocation carries its size in front of it so deletes can subtract it
+std::size_t LIVE_BYTES = 0;
+constexpr std::size_t HEADER = alignof(std::max_align_t);
+
+void* operator new(const std::size_t size)
+{
+    const auto block = static_cast<char*>(std::malloc(size + HEADER));
+    if (block == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<std::size_t*>(block) = size;
+    LIVE_BYTES += size;
+    return block + HEADER;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer == nullptr)
+    {
+        return;
+    }
+    const auto block = static_cast<char*>(pointer) - HEADER;
+    LIVE_BYTES -= *reinterpret_cast<std::size_t*>(block);
+    std::free(block);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+// Roughly the per window state the backends keep, large enough that a leak shows up in the byte count
+struct Window
+{
+    std::uint64_t id = 0;
+    std::vector<std::uint64_t> events = std::vector<std::uint64_t>(32);
+};
+
+bool check(const bool condition, const char* message)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << message << std::endl;
+    }
+    return condition;
+}
+
+int main()
+{
+    // A few long lived windows with popups and tooltips created and destroyed around them
+    constexpr std::size_t liveWindows = 16;
+    constexpr std::size_t churnWindows = 8;
+    constexpr std::size_t rounds = 500000;
+
+    SlotMap<Window> windows{};
+    std::array<std::uint64_t, liveWindows> live{};
+    for (auto& id : live)
+    {
+        id = windows.Emplace();
+        windows.Get(id)->id = id;
+    }
+
+    std::array<std::uint64_t, churnWindows> churn{};
+    const auto churnRound = [&windows, &churn]
+    {
+        for (auto& id : churn)
+        {
+            id = windows.Emplace();
+            windows.Get(id)->id = id;
+        }
+        for (const auto id : churn)
+        {
+            windows.Erase(id);
+        }
+    };
+
+    // Let every container reach its steady size before measuring
+    churnRound();
+    const auto steadyBytes = LIVE_BYTES;
+    const auto steadySlots = windows.Capacity();
+    const auto firstHandles = churn;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < rounds; round++)
+    {
+        churnRound();
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    // Taken before printing, the stream may allocate on first use
+    const auto churnedBytes = LIVE_BYTES;
+
+    std::cout << rounds * churnWindows << " windows created and destroyed, " <<
+        elapsed.count() / static_cast<double>(rounds * churnWindows) << " ns per create/destroy" << std::endl;
+    std::cout << "slots: " << windows.Capacity() << ", live bytes: " << churnedBytes << " (steady " << steadyBytes << ")"
+        << std::endl;
+
+    auto passed = true;
+    passed &= check(windows.Size() == liveWindows, "live window count changed");
+    passed &= check(windows.Capacity() == steadySlots && steadySlots == liveWindows + churnWindows,
+                    "slot count grew with windows that were destroyed");
+    passed &= check(churnedBytes == steadyBytes, "memory grew with windows that were destroyed");
+    for (const auto id : firstHandles)
+    {
+        passed &= check(windows.Get(id) == nullptr, "a destroyed handle resolved after its slot was reused");
+        passed &= check(!windows.Erase(id), "a destroyed handle erased the slot's new value");
+    }
+    for (const auto id : churn)
+    {
+        passed &= check(windows.Get(id) == nullptr, "the last destroyed handle still resolves");
+    }
+    for (const auto id : live)
+    {
+        const auto window = windows.Get(id);
+        passed &= check(window != nullptr && window->id == id, "a live handle stopped resolving");
+    }
+    passed &= check(windows.Get(0) == nullptr, "handle 0 resolved");
+    return passed ? 0 : 1;
+}
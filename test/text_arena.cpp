@@ -0,0 +1,54 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "rwin/TextArena.h"
+using namespace rwin;
+
+bool check(const bool condition, const char* message)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << message << std::endl;
+    }
+    return condition;
+}
+
+int main()
+{
+    auto passed = true;
+    TextArena arena{64};
+
+    // Enough multi byte text to span many chunks, every view has to keep pointing at its own bytes
+    std::vector<std::string> texts{};
+    std::vector<std::string_view> stored{};
+    for (auto i = 0; i < 1000; i++)
+    {
+        texts.push_back("\xe6\x97\xa5\xe6\x9c\xac " + std::to_string(i));
+        stored.push_back(arena.Store(texts.back()));
+    }
+    // Longer than a chunk, gets a chunk of its own
+    const std::string oversized(200, 'x');
+    const auto storedOversized = arena.Store(oversized);
+
+    for (std::size_t i = 0; i < texts.size(); i++)
+    {
+        passed &= check(stored[i] == texts[i], "stored text moved or was overwritten");
+    }
+    passed &= check(storedOversized == oversized, "oversized text was cut short");
+    passed &= check(arena.Store({}).empty(), "empty text took space");
+
+    std::size_t total = oversized.size();
+    for (const auto& text : texts)
+    {
+        total += text.size();
+    }
+    passed &= check(arena.Size() == total, "size does not match the stored bytes");
+
+    arena.Clear();
+    passed &= check(arena.Size() == 0, "clear left bytes behind");
+    // Reused chunks hand out the same memory again
+    const auto reused = arena.Store(texts.front());
+    passed &= check(reused == texts.front() && reused.data() == stored.front().data(), "clear did not reuse the first chunk");
+    return passed ? 0 : 1;
+}